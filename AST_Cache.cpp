@@ -0,0 +1,505 @@
+#include "AST_Cache.hpp"
+#include <thread>
+
+// Bit per field in a node record, set only when the field differs from its default.
+// The most common fields come first so the mask usually fits in a one-byte varint.
+enum Cache_Field
+{
+	FIELD_ID, FIELD_LEFT, FIELD_RIGHT, FIELD_IS_OP, FIELD_INT, FIELD_STRING, FIELD_IS_P_EXPR,
+	FIELD_FLOAT, FIELD_BOOL,
+	FIELD_CALL_NAME, FIELD_CALL_ARGS,
+	FIELD_FUNC_NAME, FIELD_FUNC_PARAMS, FIELD_FUNC_BODY, FIELD_FUNC_RETURN_TYPE,
+	FIELD_BLOCK_NAME, FIELD_BLOCK_BODY,
+	FIELD_IF_EXPR, FIELD_IF_BODY, FIELD_IF_STATEMENTS,
+	FIELD_LIST_ITEMS,
+	FIELD_WHILE_EXPR, FIELD_WHILE_BODY,
+	FIELD_RETURN_VALUE,
+	FIELD_TYPE_NAME, FIELD_TYPE_USER,
+	FIELD_TYPE_DEF_NAME, FIELD_TYPE_DEF_BODY,
+	FIELD_REF,
+	FIELD_IS_POST_OP, FIELD_IS_LIST_ITEM,
+	FIELD_FUNC_LAZY
+};
+
+const char AST_CACHE_MAGIC[4] = { 'L', 'A', 'S', 'T' };
+
+// FNV-1a
+static uint64_t hash_bytes(const char* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t hash_source(std::string_view source)
+{
+	return hash_bytes(source.data(), source.size());
+}
+
+// ########### WRITING ########### //
+
+// Integers are written as LEB128 varints (signed ones zigzag encoded) and strings as indexes
+// into a table of distinct strings, so a typical node record is a handful of bytes.
+struct Cache_Writer
+{
+	std::string buffer;
+	std::unordered_map<std::string, uint32_t> strings;
+	std::vector<const std::string*> string_table;
+
+	// Offsets are stored relative to the previous node record
+	int64_t offset = 0;
+
+	template <typename T>
+	void write(T value)
+	{
+		buffer.append((const char*)&value, sizeof(T));
+	}
+
+	void write_varint(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			buffer.push_back((char)(value | 0x80));
+			value >>= 7;
+		}
+		buffer.push_back((char)value);
+	}
+
+	void write_signed(int64_t value)
+	{
+		write_varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	}
+
+	void write_string(const std::string& value)
+	{
+		auto string = strings.emplace(value, (uint32_t)string_table.size());
+		if (string.second)
+		{
+			string_table.push_back(&string.first->first);
+		}
+		write_varint(string.first->second);
+	}
+
+	void write_string_table(Cache_Writer& payload)
+	{
+		write_varint(payload.string_table.size());
+		for (auto string : payload.string_table)
+		{
+			write_varint(string->size());
+			buffer.append(*string);
+		}
+	}
+
+	void write_nodes(std::vector<std::shared_ptr<AST_Node>>& nodes)
+	{
+		write_varint(nodes.size());
+		for (auto& node : nodes)
+		{
+			write_node(node);
+		}
+	}
+
+	void write_node(std::shared_ptr<AST_Node>& node)
+	{
+		// Type + 1, with 0 standing for a null node
+		if (!node)
+		{
+			write_varint(0);
+			return;
+		}
+
+		// Only payloads the node actually has are inspected, so writing never creates any
+		auto id = node->find_payload<ID_Node>();
+		auto string = node->find_payload<String_Node>();
+		auto type = node->find_payload<Type_Node>();
+		auto call = node->find_payload<Call_Node>();
+		auto func_def = node->find_payload<Func_Def_Node>();
+		auto block = node->find_payload<Block_Node>();
+		auto if_node = node->find_payload<If_Node>();
+		auto if_statement = node->find_payload<If_Statement_Node>();
+		auto list = node->find_payload<List_Node>();
+		auto while_loop = node->find_payload<While_Node>();
+		auto ret = node->find_payload<Return_Node>();
+		auto type_def = node->find_payload<Type_Def_Node>();
+		auto ref = node->find_payload<Ref_Node>();
+
+		uint32_t fields = 0;
+		auto set = [&fields](Cache_Field field, bool present) { if (present) fields |= 1u << field; };
+
+		set(FIELD_LEFT, node->left != nullptr);
+		set(FIELD_RIGHT, node->right != nullptr);
+		set(FIELD_INT, node->INT.value != 0);
+		set(FIELD_FLOAT, node->FLOAT.value != 0);
+		set(FIELD_BOOL, node->BOOL.value);
+		set(FIELD_ID, id && !id->value.empty());
+		set(FIELD_STRING, string && !string->value.empty());
+		set(FIELD_TYPE_NAME, type && type->id != TID_NONE);
+		set(FIELD_TYPE_USER, type && !type->built_in);
+		set(FIELD_CALL_NAME, call && !call->name.empty());
+		set(FIELD_CALL_ARGS, call && !call->args.empty());
+		set(FIELD_FUNC_NAME, func_def && !func_def->name.empty());
+		set(FIELD_FUNC_PARAMS, func_def && !func_def->params.empty());
+		set(FIELD_FUNC_BODY, func_def && !func_def->body.empty());
+		set(FIELD_FUNC_RETURN_TYPE, func_def && func_def->return_type != nullptr);
+		set(FIELD_BLOCK_NAME, block && !block->name.empty());
+		set(FIELD_BLOCK_BODY, block && !block->body.empty());
+		set(FIELD_IF_EXPR, if_node && if_node->expr != nullptr);
+		set(FIELD_IF_BODY, if_node && if_node->body != nullptr);
+		set(FIELD_IF_STATEMENTS, if_statement && !if_statement->statements.empty());
+		set(FIELD_LIST_ITEMS, list && !list->items.empty());
+		set(FIELD_WHILE_EXPR, while_loop && while_loop->expr != nullptr);
+		set(FIELD_WHILE_BODY, while_loop && !while_loop->body.empty());
+		set(FIELD_RETURN_VALUE, ret && ret->value != nullptr);
+		set(FIELD_TYPE_DEF_NAME, type_def && !type_def->name.empty());
+		set(FIELD_TYPE_DEF_BODY, type_def && !type_def->body.empty());
+		set(FIELD_REF, ref && ref->ref != nullptr);
+		set(FIELD_IS_OP, node->is_op);
+		set(FIELD_IS_POST_OP, node->is_post_op);
+		set(FIELD_IS_P_EXPR, node->is_p_expr);
+		set(FIELD_IS_LIST_ITEM, node->is_list_item);
+		set(FIELD_FUNC_LAZY, func_def && func_def->lazy != nullptr);
+
+		write_varint(node->type + 1);
+		write_signed(node->offset - offset);
+		offset = node->offset;
+		write_varint(fields);
+
+		auto has = [&fields](Cache_Field field) { return (fields & (1u << field)) != 0; };
+
+		if (has(FIELD_LEFT)) write_node(node->left);
+		if (has(FIELD_RIGHT)) write_node(node->right);
+		if (has(FIELD_INT)) write_signed(node->INT.value);
+		if (has(FIELD_FLOAT)) write<double>(node->FLOAT.value);
+		if (has(FIELD_ID)) write_string(id->value);
+		if (has(FIELD_STRING)) write_string(string->value);
+		if (has(FIELD_TYPE_NAME)) write_string(type_name(type->id));
+		if (has(FIELD_CALL_NAME)) write_string(call->name);
+		if (has(FIELD_CALL_ARGS)) write_nodes(call->args);
+		if (has(FIELD_FUNC_NAME)) write_string(func_def->name);
+		if (has(FIELD_FUNC_PARAMS)) write_nodes(func_def->params);
+		if (has(FIELD_FUNC_BODY)) write_nodes(func_def->body);
+		if (has(FIELD_FUNC_RETURN_TYPE)) write_node(func_def->return_type);
+		if (has(FIELD_BLOCK_NAME)) write_string(block->name);
+		if (has(FIELD_BLOCK_BODY)) write_nodes(block->body);
+		if (has(FIELD_IF_EXPR)) write_node(if_node->expr);
+		if (has(FIELD_IF_BODY)) write_node(if_node->body);
+		if (has(FIELD_IF_STATEMENTS)) write_nodes(if_statement->statements);
+		if (has(FIELD_LIST_ITEMS)) write_nodes(list->items);
+		if (has(FIELD_WHILE_EXPR)) write_node(while_loop->expr);
+		if (has(FIELD_WHILE_BODY)) write_nodes(while_loop->body);
+		if (has(FIELD_RETURN_VALUE)) write_node(ret->value);
+		if (has(FIELD_TYPE_DEF_NAME)) write_string(type_def->name);
+		if (has(FIELD_TYPE_DEF_BODY)) write_nodes(type_def->body);
+		if (has(FIELD_REF)) write_node(ref->ref);
+
+		// Deferred bodies stay deferred, as their source range
+		if (has(FIELD_FUNC_LAZY))
+		{
+			write_varint(func_def->lazy->begin);
+			write_varint(func_def->lazy->end - func_def->lazy->begin);
+		}
+	}
+};
+
+// ########### READING ########### //
+
+// Reads straight out of the loaded file. Any read past the end marks the cache as corrupt.
+struct Cache_Reader
+{
+	const char* data = nullptr;
+	size_t size = 0;
+	size_t index = 0;
+	bool ok = true;
+	std::vector<std::string> string_table;
+	int64_t offset = 0;
+	std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+
+	// Deferred function bodies are parsed from here
+	std::shared_ptr<Source_Buffer> source = nullptr;
+	std::string file_name = "";
+
+	template <typename T>
+	T read()
+	{
+		T value{};
+		if (!ok || size - index < sizeof(T))
+		{
+			ok = false;
+			return value;
+		}
+
+		memcpy(&value, data + index, sizeof(T));
+		index += sizeof(T);
+		return value;
+	}
+
+	uint64_t read_varint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			uint8_t byte = read<uint8_t>();
+			value |= (uint64_t)(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+			{
+				return value;
+			}
+		}
+
+		ok = false;
+		return 0;
+	}
+
+	int64_t read_signed()
+	{
+		uint64_t value = read_varint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	const std::string& read_string()
+	{
+		static const std::string empty;
+
+		uint64_t string = read_varint();
+		if (!ok || string >= string_table.size())
+		{
+			ok = false;
+			return empty;
+		}
+
+		return string_table[string];
+	}
+
+	void read_string_table()
+	{
+		uint64_t count = read_varint();
+		if (!ok || count > size - index)
+		{
+			ok = false;
+			return;
+		}
+
+		string_table.reserve(count);
+		for (uint64_t i = 0; i < count && ok; i++)
+		{
+			uint64_t length = read_varint();
+			if (!ok || size - index < length)
+			{
+				ok = false;
+				return;
+			}
+
+			string_table.emplace_back(data + index, length);
+			index += length;
+		}
+	}
+
+	void read_nodes(std::vector<std::shared_ptr<AST_Node>>& nodes)
+	{
+		uint64_t count = read_varint();
+
+		// Every node record is at least one byte, so larger counts can only come from corruption
+		if (!ok || count > size - index)
+		{
+			ok = false;
+			return;
+		}
+
+		nodes.reserve(count);
+		for (uint64_t i = 0; i < count && ok; i++)
+		{
+			nodes.push_back(read_node());
+		}
+	}
+
+	std::shared_ptr<AST_Node> read_node()
+	{
+		uint64_t type = read_varint();
+		if (type == 0)
+		{
+			return nullptr;
+		}
+
+		auto node = make_node(arena, (Type)(type - 1));
+		offset = node->offset = offset + read_signed();
+		uint64_t fields = read_varint();
+
+		if (!ok)
+		{
+			return nullptr;
+		}
+
+		auto has = [&fields](Cache_Field field) { return (fields & (1u << field)) != 0; };
+
+		if (has(FIELD_LEFT)) node->left = read_node();
+		if (has(FIELD_RIGHT)) node->right = read_node();
+		if (has(FIELD_INT)) node->INT.value = read_signed();
+		if (has(FIELD_FLOAT)) node->FLOAT.value = read<double>();
+		if (has(FIELD_ID)) node->ID() = ID_Node(read_string());
+		if (has(FIELD_STRING)) node->STRING().value = read_string();
+		if (has(FIELD_TYPE_NAME)) node->TYPE().id = register_type(read_string());
+		if (has(FIELD_CALL_NAME)) node->CALL().name = read_string();
+		if (has(FIELD_CALL_ARGS)) read_nodes(node->CALL().args);
+		if (has(FIELD_FUNC_NAME)) node->FUNC_DEF().name = read_string();
+		if (has(FIELD_FUNC_PARAMS)) read_nodes(node->FUNC_DEF().params);
+		if (has(FIELD_FUNC_BODY)) read_nodes(node->FUNC_DEF().body);
+		if (has(FIELD_FUNC_RETURN_TYPE)) node->FUNC_DEF().return_type = read_node();
+		if (has(FIELD_BLOCK_NAME)) node->BLOCK().name = read_string();
+		if (has(FIELD_BLOCK_BODY)) read_nodes(node->BLOCK().body);
+		if (has(FIELD_IF_EXPR)) node->IF().expr = read_node();
+		if (has(FIELD_IF_BODY)) node->IF().body = read_node();
+		if (has(FIELD_IF_STATEMENTS)) read_nodes(node->IF_STATEMENT().statements);
+		if (has(FIELD_LIST_ITEMS)) read_nodes(node->LIST().items);
+		if (has(FIELD_WHILE_EXPR)) node->WHILE().expr = read_node();
+		if (has(FIELD_WHILE_BODY)) read_nodes(node->WHILE().body);
+		if (has(FIELD_RETURN_VALUE)) node->RETURN().value = read_node();
+		if (has(FIELD_TYPE_DEF_NAME))
+		{
+			node->TYPE_DEF().name = read_string();
+			node->TYPE_DEF().id = register_type(node->TYPE_DEF().name);
+		}
+		if (has(FIELD_TYPE_DEF_BODY)) read_nodes(node->TYPE_DEF().body);
+		if (has(FIELD_REF)) node->REF().ref = read_node();
+
+		if (has(FIELD_FUNC_LAZY))
+		{
+			auto lazy = std::make_shared<Lazy_Body>();
+			lazy->source = source;
+			lazy->file_name = file_name;
+			lazy->begin = read_varint();
+			lazy->end = lazy->begin + read_varint();
+			if (lazy->end > source->view().size())
+			{
+				ok = false;
+				return nullptr;
+			}
+
+			node->FUNC_DEF().lazy = lazy;
+			lazy_body_stats().deferred++;
+		}
+
+		node->BOOL.value = has(FIELD_BOOL);
+		if (auto type_node = node->find_payload<Type_Node>())
+		{
+			type_node->built_in = !has(FIELD_TYPE_USER);
+		}
+		node->is_op = has(FIELD_IS_OP);
+		node->is_post_op = has(FIELD_IS_POST_OP);
+		node->is_p_expr = has(FIELD_IS_P_EXPR);
+		node->is_list_item = has(FIELD_IS_LIST_ITEM);
+
+
+		return node;
+	}
+};
+
+// ########### FILES ########### //
+
+bool save_ast_cache(const std::string& file_name, std::string_view source, std::vector<std::shared_ptr<AST_Node>>& expressions)
+{
+	Cache_Writer nodes;
+	nodes.write_nodes(expressions);
+
+	Cache_Writer payload;
+	payload.write_string_table(nodes);
+	payload.buffer.append(nodes.buffer);
+
+	Cache_Writer header;
+	header.buffer.append(AST_CACHE_MAGIC, sizeof(AST_CACHE_MAGIC));
+	header.write<uint32_t>(AST_CACHE_VERSION);
+	header.write<uint64_t>(hash_source(source));
+	header.write<uint64_t>(source.size());
+	header.write<uint64_t>(hash_source(payload.buffer));
+
+	std::ofstream stream(file_name + ".astc", std::ios::binary | std::ios::trunc);
+	stream.write(header.buffer.data(), header.buffer.size());
+	stream.write(payload.buffer.data(), payload.buffer.size());
+	return stream.good();
+}
+
+bool load_ast_cache(const std::string& file_name, std::shared_ptr<Source_Buffer> source, std::vector<std::shared_ptr<AST_Node>>& expressions)
+{
+	std::ifstream stream(file_name + ".astc", std::ios::binary | std::ios::ate);
+	if (!stream)
+	{
+		return false;
+	}
+
+	std::string buffer(stream.tellg(), '\0');
+	stream.seekg(0);
+	stream.read(&buffer[0], buffer.size());
+	if (!stream)
+	{
+		return false;
+	}
+
+	Cache_Reader reader;
+	reader.data = buffer.data();
+	reader.size = buffer.size();
+	reader.source = source;
+	reader.file_name = file_name;
+
+	char magic[sizeof(AST_CACHE_MAGIC)];
+	for (char& c : magic)
+	{
+		c = reader.read<char>();
+	}
+
+	if (!reader.ok || memcmp(magic, AST_CACHE_MAGIC, sizeof(magic)) != 0
+		|| reader.read<uint32_t>() != AST_CACHE_VERSION
+		|| reader.read<uint64_t>() != hash_source(source->view())
+		|| reader.read<uint64_t>() != source->view().size())
+	{
+		return false;
+	}
+
+	uint64_t payload_hash = reader.read<uint64_t>();
+	if (!reader.ok || payload_hash != hash_bytes(buffer.data() + reader.index, buffer.size() - reader.index))
+	{
+		return false;
+	}
+
+	std::vector<std::shared_ptr<AST_Node>> cached;
+	reader.read_string_table();
+	reader.read_nodes(cached);
+
+	if (!reader.ok || reader.index != buffer.size())
+	{
+		return false;
+	}
+
+	expressions = std::move(cached);
+	return true;
+}
+
+AST_Parser parse_cached(Lexer& lexer)
+{
+	AST_Parser parser;
+	parser.file_name = lexer.get_file_name();
+	parser.source = lexer.get_buffer();
+
+	if (load_ast_cache(lexer.get_file_name(), lexer.get_buffer(), parser.expressions))
+	{
+		return parser;
+	}
+
+	// Large sources are lexed up front on every core; the rest stream into the parser
+	unsigned threads = std::thread::hardware_concurrency();
+	if (threads > 1 && lexer.get_source().size() >= Lexer::PARALLEL_THRESHOLD)
+	{
+		lexer.tokenize_parallel(threads, Lexer::PARALLEL_CHUNK);
+	}
+
+	parser = AST_Parser(lexer);
+	parser.parse();
+
+	if (!lexer.has_errors && !parser.has_errors)
+	{
+		save_ast_cache(lexer.get_file_name(), lexer.get_source(), parser.expressions);
+	}
+
+	return parser;
+}
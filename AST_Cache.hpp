@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "AST_Parser.hpp"
+
+// Parsed expressions are cached next to their source as '<file>.astc'. A cache file is only
+// used if its version matches, its payload checksum is intact and it was written for a source
+// with the same content hash; anything else falls back to lexing and parsing.
+const uint32_t AST_CACHE_VERSION = 5;
+
+uint64_t hash_source(std::string_view source);
+
+bool save_ast_cache(const std::string& file_name, std::string_view source, std::vector<std::shared_ptr<AST_Node>>& expressions);
+
+bool load_ast_cache(const std::string& file_name, std::shared_ptr<Source_Buffer> source, std::vector<std::shared_ptr<AST_Node>>& expressions);
+
+// Lexes and parses 'lexer', or loads the result from the cache if the source is unchanged.
+// Successful parses refresh the cache.
+AST_Parser parse_cached(Lexer& lexer);
@@ -0,0 +1,402 @@
+#include "AST_Compiler.hpp"
+
+int AST_Compiler::emit(Op op, int arg)
+{
+	chunk->code.push_back({ op, arg });
+	return chunk->code.size() - 1;
+}
+
+int AST_Compiler::add_node(std::shared_ptr<AST_Node>& node)
+{
+	chunk->nodes.push_back(node);
+	chunk->caches.push_back({});
+	return chunk->nodes.size() - 1;
+}
+
+int AST_Compiler::add_constant(VM_Value value)
+{
+	chunk->constants.push_back(value);
+	return chunk->constants.size() - 1;
+}
+
+void AST_Compiler::patch(int jump)
+{
+	chunk->code[jump].arg = chunk->code.size();
+}
+
+void AST_Compiler::emit_scope_exits(int depth)
+{
+	for (int i = depth; i < scope_depth; i++)
+	{
+		emit(OP_EXIT_SCOPE);
+	}
+}
+
+// ########### STATEMENTS ########### //
+
+void AST_Compiler::compile_statement(std::shared_ptr<AST_Node>& node, Op end)
+{
+	statement_exits.clear();
+
+	if (end == OP_POP && node->type == TYPE_EQUAL && node->left && node->left->type == TYPE_ID)
+	{
+		compile_assignment(node, false);
+	}
+	else
+	{
+		compile_expr(node);
+		emit(end);
+	}
+
+	for (int jump : statement_exits)
+	{
+		patch(jump);
+	}
+	statement_exits.clear();
+}
+
+void AST_Compiler::compile_body(std::vector<std::shared_ptr<AST_Node>>& body)
+{
+	for (auto& expr : body)
+	{
+		if (expr->type == TYPE_EQUAL && expr->left && expr->left->type == TYPE_ID)
+		{
+			compile_assignment(expr, false);
+		}
+		else
+		{
+			compile_expr(expr);
+			emit(OP_POP);
+		}
+	}
+}
+
+// ########### EXPRESSIONS ########### //
+
+void AST_Compiler::compile_expr(std::shared_ptr<AST_Node>& node, bool value)
+{
+	if (!node)
+	{
+		emit(OP_CONSTANT, add_constant(VM_Value(std::make_shared<AST_Node>(TYPE_ERROR))));
+		return;
+	}
+
+	switch (node->type)
+	{
+		case TYPE_INT:
+			emit(OP_CONSTANT, add_constant(VM_Value(node->INT.value)));
+			return;
+		case TYPE_FLOAT:
+			emit(OP_CONSTANT, add_constant(VM_Value(node->FLOAT.value)));
+			return;
+		case TYPE_BOOL:
+			emit(OP_CONSTANT, add_constant(VM_Value(node->BOOL.value)));
+			return;
+		case TYPE_ID:
+			emit(value ? OP_LOAD_VALUE : OP_LOAD, add_node(node));
+			return;
+		case TYPE_PLUS:
+			compile_binary(node, OP_ADD);
+			return;
+		case TYPE_MINUS:
+			compile_binary(node, OP_SUB);
+			return;
+		case TYPE_STAR:
+			compile_binary(node, OP_MUL);
+			return;
+		case TYPE_SLASH:
+			compile_binary(node, OP_DIV);
+			return;
+		case TYPE_EQ_EQ:
+			compile_binary(node, OP_EQ);
+			return;
+		case TYPE_NOT_EQUAL:
+			compile_binary(node, OP_NOT_EQ);
+			return;
+		case TYPE_NEG:
+			compile_expr(node->right, true);
+			emit(OP_NEG, add_node(node));
+			return;
+		case TYPE_POS:
+			compile_expr(node->right, true);
+			emit(OP_POS, add_node(node));
+			return;
+		case TYPE_EQUAL:
+			compile_assignment(node, true);
+			return;
+		case TYPE_BLOCK:
+			compile_block(node);
+			return;
+		case TYPE_DOUBLE_COLON:
+			compile_scope_accessor(node);
+			return;
+		case TYPE_CALL:
+			compile_call(node);
+			return;
+		case TYPE_FUNC_DEF:
+			emit(OP_DEF, add_node(node));
+			return;
+		case TYPE_RETURN:
+			compile_return(node);
+			return;
+		case TYPE_WHILE:
+			compile_while(node);
+			return;
+		case TYPE_IF_ELSE_STATEMENT:
+			compile_if_else(node);
+			return;
+		case TYPE_BREAK:
+			compile_break(false);
+			return;
+		case TYPE_BREAK_ALL:
+			compile_break(true);
+			return;
+		default:
+			emit(OP_CONSTANT, add_constant(VM_Value(node)));
+			return;
+	}
+}
+
+void AST_Compiler::compile_binary(std::shared_ptr<AST_Node>& node, Op op)
+{
+	compile_expr(node->left, true);
+	compile_expr(node->right, true);
+	emit(op, add_node(node));
+}
+
+// ########### ASSIGNMENT ########### //
+
+void AST_Compiler::compile_assignment(std::shared_ptr<AST_Node>& node, bool keep)
+{
+	compile_expr(node->right);
+
+	if (node->left->type == TYPE_ID)
+	{
+		emit(keep ? OP_STORE : OP_STORE_POP, add_node(node));
+	}
+	else if (node->left->type == TYPE_DOUBLE_COLON)
+	{
+		compile_scope_accessor(node->left);
+		emit(OP_STORE_VAR, add_node(node));
+	}
+	else
+	{
+		emit(OP_POP);
+		emit(OP_CONSTANT, add_constant(VM_Value(node)));
+	}
+
+	if (!keep && node->left->type != TYPE_ID)
+	{
+		emit(OP_POP);
+	}
+}
+
+// ########### BLOCK ########### //
+
+void AST_Compiler::compile_block(std::shared_ptr<AST_Node>& node)
+{
+	emit(OP_ENTER_SCOPE, add_node(node));
+	scope_depth++;
+
+	compile_body(node->BLOCK().body);
+
+	scope_depth--;
+	emit(OP_EXIT_SCOPE);
+	emit(OP_CONSTANT, add_constant(VM_Value(std::make_shared<AST_Node>(TYPE_EMPTY))));
+}
+
+// ########### DOUBLE_COLON ########### //
+
+void AST_Compiler::compile_scope_accessor(std::shared_ptr<AST_Node>& node)
+{
+	// Only '::' and call results are pushed, OP_ACCESS looks identifiers up itself
+	if (node->left->type == TYPE_DOUBLE_COLON)
+	{
+		compile_scope_accessor(node->left);
+	}
+	else if (node->left->type == TYPE_CALL)
+	{
+		compile_call(node->left);
+	}
+
+	emit(OP_ACCESS, add_node(node));
+}
+
+// ########### IF/ELSE ########### //
+
+void AST_Compiler::compile_if_else(std::shared_ptr<AST_Node>& node)
+{
+	std::vector<int> exits;
+
+	for (auto& if_stmnt : node->IF_STATEMENT().statements)
+	{
+		int next = -1;
+
+		if (if_stmnt->type != TYPE_ELSE)
+		{
+			compile_expr(if_stmnt->IF().expr, true);
+			next = emit(OP_JUMP_IF_FALSE);
+		}
+
+		compile_body(if_stmnt->IF().body->BLOCK().body);
+
+		if (next == -1)
+		{
+			break;
+		}
+
+		exits.push_back(emit(OP_JUMP));
+		patch(next);
+	}
+
+	for (int jump : exits)
+	{
+		patch(jump);
+	}
+
+	emit(OP_CONSTANT, add_constant(VM_Value(std::make_shared<AST_Node>(TYPE_EMPTY))));
+}
+
+// ########### WHILE ########### //
+
+void AST_Compiler::compile_while(std::shared_ptr<AST_Node>& node)
+{
+	int start = chunk->code.size();
+
+	compile_expr(node->WHILE().expr, true);
+	int exit = emit(OP_JUMP_IF_FALSE);
+
+	loops.push_back({ scope_depth, {} });
+	compile_body(node->WHILE().body);
+	emit(OP_JUMP, start);
+
+	patch(exit);
+	for (int jump : loops.back().breaks)
+	{
+		patch(jump);
+	}
+	loops.pop_back();
+
+	emit(OP_CONSTANT, add_constant(VM_Value(std::make_shared<AST_Node>(TYPE_EMPTY))));
+}
+
+void AST_Compiler::compile_break(bool all)
+{
+	if (!all && loops.size() > 0)
+	{
+		emit_scope_exits(loops.back().scope_depth);
+		loops.back().breaks.push_back(emit(OP_JUMP));
+		return;
+	}
+
+	emit_scope_exits(0);
+	statement_exits.push_back(emit(OP_JUMP));
+}
+
+// ########### RETURN ########### //
+
+void AST_Compiler::compile_return(std::shared_ptr<AST_Node>& node)
+{
+	compile_expr(node->RETURN().value);
+
+	if (in_function)
+	{
+		emit(OP_RETURN);
+		return;
+	}
+
+	emit(OP_POP);
+	compile_break(true);
+}
+
+// ########### CALL ########### //
+
+void AST_Compiler::compile_call(std::shared_ptr<AST_Node>& node)
+{
+	auto& name = node->CALL().name;
+	auto& args = node->CALL().args;
+
+	if (name == "print")
+	{
+		// Each argument prints before the next one runs, like eval_call
+		if (args.empty())
+		{
+			emit(OP_PRINT, 0);
+			return;
+		}
+
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			if (i > 0)
+			{
+				emit(OP_POP);
+			}
+			compile_expr(args[i], true);
+			emit(OP_PRINT, 1);
+		}
+		return;
+	}
+
+	if (name == "type_of" || name == "str" || name == "ref" || name == "import")
+	{
+		if (args.size() != 1)
+		{
+			emit(OP_BUILTIN_ERROR, add_node(node));
+			return;
+		}
+
+		if (name == "import")
+		{
+			emit(OP_IMPORT, add_node(node));
+			return;
+		}
+
+		compile_expr(args[0]);
+		emit(name == "type_of" ? OP_TYPE_OF : name == "str" ? OP_STR : OP_REF, add_node(node));
+		return;
+	}
+
+	// The function is looked up and its arity checked before any argument runs, like eval_call.
+	// OP_LOAD_FUNC skips the jump when the call can go ahead.
+	int call = add_node(node);
+	emit(OP_LOAD_FUNC, call);
+	int skip = emit(OP_JUMP);
+
+	for (auto& arg : args)
+	{
+		compile_expr(arg);
+	}
+	emit(OP_CALL, call);
+	patch(skip);
+}
+
+// ########### ENTRY POINTS ########### //
+
+std::shared_ptr<Chunk> AST_Compiler::compile(std::vector<std::shared_ptr<AST_Node>>& expressions)
+{
+	chunk = std::make_shared<Chunk>();
+	in_function = false;
+
+	for (auto& expr : expressions)
+	{
+		compile_statement(expr, OP_END_STATEMENT);
+	}
+
+	emit(OP_HALT);
+	return chunk;
+}
+
+std::shared_ptr<Chunk> AST_Compiler::compile_function(std::shared_ptr<AST_Node>& func)
+{
+	chunk = std::make_shared<Chunk>();
+	in_function = true;
+
+	for (auto& expr : func->FUNC_DEF().body)
+	{
+		compile_statement(expr);
+	}
+
+	emit(OP_CONSTANT, add_constant(VM_Value(std::make_shared<AST_Node>(TYPE_EMPTY))));
+	emit(OP_RETURN);
+	return chunk;
+}
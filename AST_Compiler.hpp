@@ -0,0 +1,62 @@
+#pragma once
+#include "AST_Node.hpp"
+#include "Bytecode.hpp"
+
+// Compiles the expressions produced by AST_Parser into a Chunk for the VM. Each compiled
+// expression leaves exactly one value on the stack; statements pop it.
+class AST_Compiler
+{
+	struct Loop
+	{
+		int scope_depth = 0;
+		std::vector<int> breaks;
+	};
+
+	std::shared_ptr<Chunk> chunk = nullptr;
+	bool in_function = false;
+	int scope_depth = 0;
+	std::vector<Loop> loops;
+
+	// Jumps to the end of the current body-level statement ('break_all', or 'break' outside a loop)
+	std::vector<int> statement_exits;
+
+	int emit(Op op, int arg = 0);
+
+	int add_node(std::shared_ptr<AST_Node>& node);
+
+	int add_constant(VM_Value value);
+
+	void patch(int jump);
+
+	void emit_scope_exits(int depth);
+
+	void compile_statement(std::shared_ptr<AST_Node>& node, Op end = OP_POP);
+
+	void compile_body(std::vector<std::shared_ptr<AST_Node>>& body);
+
+	void compile_expr(std::shared_ptr<AST_Node>& node, bool value = false);
+
+	void compile_binary(std::shared_ptr<AST_Node>& node, Op op);
+
+	void compile_assignment(std::shared_ptr<AST_Node>& node, bool keep);
+
+	void compile_block(std::shared_ptr<AST_Node>& node);
+
+	void compile_scope_accessor(std::shared_ptr<AST_Node>& node);
+
+	void compile_if_else(std::shared_ptr<AST_Node>& node);
+
+	void compile_while(std::shared_ptr<AST_Node>& node);
+
+	void compile_break(bool all);
+
+	void compile_return(std::shared_ptr<AST_Node>& node);
+
+	void compile_call(std::shared_ptr<AST_Node>& node);
+
+public:
+
+	std::shared_ptr<Chunk> compile(std::vector<std::shared_ptr<AST_Node>>& expressions);
+
+	std::shared_ptr<Chunk> compile_function(std::shared_ptr<AST_Node>& func);
+};
@@ -1,1803 +1,1786 @@
 #include "AST_Eval.hpp"
 
-std::string not_implemented_error(std::shared_ptr<AST_Node>& op)
+std::string not_implemented_error(Type op, std::shared_ptr<AST_Node> left, std::shared_ptr<AST_Node> right)
 {
-	if (op->left == nullptr)
+	if (left == nullptr)
 	{
-		return "Cannot perform '" + type_repr(op->type) + "' on '" + type_repr(op->right->type) + "'.";
+		return "Cannot perform '" + type_repr(op) + "' on '" + type_repr(right->type) + "'.";
 	}
 
-	return "Cannot perform '" + type_repr(op->type) + "' on '" + type_repr(op->left->type) + "' and '" + type_repr(op->right->type) + "'.";
+	return "Cannot perform '" + type_repr(op) + "' on '" + type_repr(left->type) + "' and '" + type_repr(right->type) + "'.";
 }
 
 void AST_Eval::init()
 {
-	global_scope->SCOPE.name = "global";
-	global_scope->SCOPE.types =
-	{
-		"int", "bool", "float", "string", "scope", "any"
-	};
+	global_scope->SCOPE().name = "global";
 }
 
-std::shared_ptr<AST_Node> AST_Eval::infer_type(std::shared_ptr<AST_Node>& node)
+// ########### TYPES ########### //
+
+// One shared node per type id. Results are never mutated, so every type_of() and
+// infer_type() of the same type can hand out the same node.
+static std::shared_ptr<AST_Node>& type_node(int id)
 {
-	std::shared_ptr<AST_Node> type = std::make_shared<AST_Node>(TYPE_TYPE);
+	static std::vector<std::shared_ptr<AST_Node>> nodes;
 
-	switch (node->type)
+	if ((size_t)id >= nodes.size())
+	{
+		nodes.resize(id + 1);
+	}
+
+	auto& node = nodes[id];
+	if (!node)
 	{
-	case TYPE_INT:
-		type->TYPE.name = "int";
-		return type;
-	case TYPE_FLOAT:
-		type->TYPE.name = "float";
-		return type;
-	case TYPE_BOOL:
-		type->TYPE.name = "bool";
-		return type;
-	case TYPE_STRING:
-		type->TYPE.name = "string";
-		return type;
-	case TYPE_LIST:
-		type->TYPE.name = "list";
-		return type;
-	case TYPE_TYPE:
-		type->TYPE.name = "type";
-		return type;
-	case TYPE_SCOPE:
-		type->TYPE.name = "scope";
-		return type;
-	case TYPE_VAR:
-		type = infer_type(node->VAR.value);
-		return type;
-	default:
-		type->TYPE.built_in = false;
-		return type;
+		node = std::make_shared<AST_Node>(TYPE_TYPE);
+		node->TYPE().id = id;
+		node->TYPE().built_in = id != TID_NONE;
 	}
+
+	return node;
+}
+
+std::shared_ptr<AST_Node> AST_Eval::infer_type(std::shared_ptr<AST_Node>& node)
+{
+	return type_node(infer_type_id(node));
+}
+
+int AST_Eval::infer_type_id(std::shared_ptr<AST_Node>& node)
+{
+	return node->type == TYPE_VAR ? node->VAR().type : value_type_id(node->type);
 }
 
-int AST_Eval::implicit_cast(std::shared_ptr<AST_Node>& value, std::string type)
+enum Cast_Result
 {
-	int ok = 0;
-	int data_loss = 1;
-	int error = 2;
+	CAST_OK,
+	CAST_DATA_LOSS,
+	CAST_ERROR,
+};
 
-	if (value->type == TYPE_INT && type == "float")
+// Converts a copy of the value in place
+using Cast_Handler = void (*)(AST_Node& value);
+
+// Pairs without a handler can't be cast
+struct Cast
+{
+	Cast_Result result = CAST_ERROR;
+	Cast_Handler handler = nullptr;
+};
+
+template <Type To, Type From>
+static void convert(AST_Node& value)
+{
+	auto from = From == TYPE_INT ? (double)value.INT.value : From == TYPE_FLOAT ? value.FLOAT.value : (double)value.BOOL.value;
+	value.type = To;
+
+	if constexpr (To == TYPE_INT)
 	{
-		value->type = TYPE_FLOAT;
-		value->FLOAT.value = (float)value->INT.value;
-		return ok;
+		value.INT.value = (int64_t)from;
 	}
-	if (value->type == TYPE_FLOAT && type == "int")
+	else if constexpr (To == TYPE_FLOAT)
 	{
-		value->type = TYPE_INT;
-		value->INT.value = (int)value->FLOAT.value;
-		return data_loss;
+		value.FLOAT.value = (double)from;
 	}
-	if (value->type == TYPE_BOOL && type == "int")
+	else
 	{
-		value->type = TYPE_INT;
-		value->INT.value = (int)value->BOOL.value;
-		return ok;
+		value.BOOL.value = (bool)from;
 	}
-	if (value->type == TYPE_INT && type == "bool")
+}
+
+// Implicit casts between built-in types, by [from][to] type id. User types never cast.
+struct Cast_Table
+{
+	Cast casts[TID_BUILT_IN_COUNT][TID_BUILT_IN_COUNT] = {};
+
+	constexpr void set(int from, int to, Cast_Result result, Cast_Handler handler)
 	{
-		value->type = TYPE_BOOL;
-		value->BOOL.value = (bool)value->INT.value;
-		return data_loss;
+		casts[from][to] = { result, handler };
 	}
-	if (value->type == TYPE_FLOAT && type == "bool")
+
+	const Cast& find(int from, int to) const
 	{
-		value->type = TYPE_BOOL;
-		value->BOOL.value = (bool)value->FLOAT.value;
-		return data_loss;
+		static const Cast none;
+		return from < TID_BUILT_IN_COUNT && to < TID_BUILT_IN_COUNT ? casts[from][to] : none;
 	}
-	if (value->type == TYPE_BOOL && type == "float")
+};
+
+static constexpr Cast_Table CAST_TABLE = []()
+{
+	Cast_Table table;
+	table.set(TID_INT, TID_FLOAT, CAST_OK, convert<TYPE_FLOAT, TYPE_INT>);
+	table.set(TID_FLOAT, TID_INT, CAST_DATA_LOSS, convert<TYPE_INT, TYPE_FLOAT>);
+	table.set(TID_BOOL, TID_INT, CAST_OK, convert<TYPE_INT, TYPE_BOOL>);
+	table.set(TID_INT, TID_BOOL, CAST_DATA_LOSS, convert<TYPE_BOOL, TYPE_INT>);
+	table.set(TID_FLOAT, TID_BOOL, CAST_DATA_LOSS, convert<TYPE_BOOL, TYPE_FLOAT>);
+	table.set(TID_BOOL, TID_FLOAT, CAST_OK, convert<TYPE_FLOAT, TYPE_BOOL>);
+	return table;
+}();
+
+int AST_Eval::implicit_cast(std::shared_ptr<AST_Node>& value, int type)
+{
+	const Cast& cast = CAST_TABLE.find(value_type_id(value->type), type);
+
+	if (!cast.handler)
 	{
-		value->type = TYPE_FLOAT;
-		value->FLOAT.value = (float)value->BOOL.value;
-		return ok;
+		return CAST_ERROR;
 	}
 
-	return error;
+	value = create_copy(value);
+	cast.handler(*value);
+	return cast.result;
 }
 
-std::shared_ptr<AST_Node> AST_Eval::create_var(std::string name, std::shared_ptr<AST_Node> value, 
-	std::shared_ptr<AST_Node> type)
+std::shared_ptr<AST_Node> AST_Eval::create_var(std::string name, std::shared_ptr<AST_Node> value, int type)
 {
 	auto var = std::make_shared<AST_Node>(TYPE_VAR);
-	var->VAR.name = name;
-	var->VAR.value = value;
+	var->VAR().symbol = intern(name);
+	var->VAR().set(value);
 
-	if (type)
+	if (type != -1)
 	{
-		var->VAR.type = type;
+		var->VAR().type = type;
 	}
 	else
 	{
-		var->VAR.type = infer_type(var->VAR.value);
+		var->VAR().type = infer_type_id(value);
 	}
 
 	return var;
 }
 
-std::shared_ptr<AST_Node> AST_Eval::get_data(std::string name)
+std::shared_ptr<AST_Node> AST_Eval::get_data(const std::string& name)
 {
-	auto scope = current_scope;
+	return get_data(find_symbol(name));
+}
+
+std::shared_ptr<AST_Node> AST_Eval::get_data(ID_Node& id)
+{
+	if (auto slot = find_slot(id))
+	{
+		return *slot;
+	}
 
-	auto var = get_data_from_scope(name, scope);
+	return get_data(id.symbol);
+}
 
-	while (!var)
+std::shared_ptr<AST_Node>* AST_Eval::find_slot(ID_Node& id)
+{
+	if (id.slot == -1)
 	{
-		scope = scope->SCOPE.parent;
+		return nullptr;
+	}
 
-		if (scope == nullptr)
-		{
-			return var;
-		}
+	auto scope = current_scope.get();
+	for (int i = 0; i < id.depth; i++)
+	{
+		scope = scope->SCOPE().parent.get();
+	}
 
-		var = get_data_from_scope(name, scope);
+	auto& slots = scope->SCOPE().slots;
+	if ((size_t)id.slot < slots.size() && slots[id.slot])
+	{
+		return &slots[id.slot];
 	}
 
-	return var;
+	return nullptr;
 }
 
-std::shared_ptr<AST_Node> AST_Eval::get_data_from_scope(std::string name, std::shared_ptr<AST_Node> scope)
+std::shared_ptr<AST_Node> AST_Eval::get_data(int symbol)
 {
-	for (auto& data : scope->SCOPE.data)
+	if (symbol == -1)
+	{
+		return nullptr;
+	}
+
+	for (auto scope = current_scope.get(); scope; scope = scope->SCOPE().parent.get())
 	{
-		if (data->VAR.name == name)
+		for (auto& param : scope->SCOPE().params)
+		{
+			if (param->VAR().symbol == symbol)
+			{
+				return param;
+			}
+		}
+
+		auto var = scope->SCOPE().index.find(symbol);
+		if (var != scope->SCOPE().index.end())
 		{
-			return data;
+			return var->second;
 		}
 	}
 
 	return nullptr;
 }
 
-void AST_Eval::eval(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::get_data_from_scope(const std::string& name, std::shared_ptr<AST_Node> scope)
+{
+	auto scope_node = scope->find_payload<Scope_Node>();
+	if (!scope_node)
+	{
+		return nullptr;
+	}
+
+	auto var = scope_node->index.find(find_symbol(name));
+
+	if (var == scope_node->index.end())
+	{
+		return nullptr;
+	}
+
+	return var->second;
+}
+
+void AST_Eval::add_data_to_scope(std::shared_ptr<AST_Node> var, std::shared_ptr<AST_Node> scope)
+{
+	scope->SCOPE().data.push_back(var);
+	scope->SCOPE().index.emplace(var->VAR().symbol, var);
+}
+
+void AST_Eval::add_data_to_scope(std::shared_ptr<AST_Node> var, std::shared_ptr<AST_Node> scope, ID_Node& id)
+{
+	add_data_to_scope(var, scope);
+
+	if (id.depth == 0 && id.slot != -1 && (size_t)id.slot < scope->SCOPE().slots.size())
+	{
+		scope->SCOPE().slots[id.slot] = var;
+	}
+}
+
+std::shared_ptr<AST_Node> AST_Eval::create_error(std::shared_ptr<AST_Node>& node)
+{
+	auto error = std::make_shared<AST_Node>(TYPE_ERROR);
+	error->offset = node->offset;
+	return error;
+}
+
+bool AST_Eval::is_control(std::shared_ptr<AST_Node>& result)
+{
+	return result->type == TYPE_BREAK || result->type == TYPE_BREAK_ALL || result->type == TYPE_RETURN;
+}
+
+std::shared_ptr<AST_Node> AST_Eval::eval(std::shared_ptr<AST_Node>& node)
 {
 	if (!node)
 	{
-		node = std::make_shared<AST_Node>(TYPE_ERROR);
-		return;
+		return std::make_shared<AST_Node>(TYPE_ERROR);
+	}
+
+	if (node->quick >= QUICK_SLOT)
+	{
+		return eval_quick(node);
 	}
 
 	switch (node->type)
 	{
-		case TYPE_INT:
-			return;
-		case TYPE_FLOAT:
-			return;
-		case TYPE_BOOL:
-			return;
-		case TYPE_STRING:
-			return;
-		case TYPE_LIST:
-			return;
-		case TYPE_TYPE:
-			return;
-		case TYPE_BREAK:
-			return;
-		case TYPE_BREAK_ALL:
-			return;
 		case TYPE_ID:
-			eval_id(node);
-			return;
+			return eval_id(node);
 		case TYPE_PLUS:
-			eval_plus(node);
-			return;
+			return eval_plus(node);
 		case TYPE_MINUS:
-			eval_minus(node);
-			return;
+			return eval_minus(node);
 		case TYPE_STAR:
-			eval_mul(node);
-			return;
+			return eval_mul(node);
 		case TYPE_SLASH:
-			eval_div(node);
-			return;
+			return eval_div(node);
 		case TYPE_NEG:
-			eval_neg(node);
-			return;
+			return eval_neg(node);
 		case TYPE_POS:
-			eval_pos(node);
-			return;
+			return eval_pos(node);
 		case TYPE_EQUAL:
-			eval_assignment(node);
-			return;
+			return eval_assignment(node);
 		case TYPE_BLOCK:
-			eval_block(node);
-			return;
+			return eval_block(node);
 		case TYPE_DOUBLE_COLON:
-			eval_scope_accessor(node);
-			return;
+			return eval_scope_accessor(node);
 		case TYPE_COLON:
 			//eval_type_assignment(node);
-			return;
+			return node;
 		case TYPE_CALL:
-			eval_call(node);
-			return;
+			return eval_call(node);
 		case TYPE_VAR:
-			eval_var(node);
-			return;
+		{
+			auto value = node;
+			eval_var(value);
+			return value;
+		}
 		case TYPE_FUNC_DEF:
-			eval_func_def(node);
-			return;
+			return eval_func_def(node);
+		case TYPE_RETURN:
+			return eval_return(node);
 		case TYPE_WHILE:
-			eval_while(node);
-			return;
+			return eval_while(node);
 		case TYPE_IF_ELSE_STATEMENT:
-			eval_if_else(node);
-			return;
+			return eval_if_else(node);
 		case TYPE_EQ_EQ:
-			eval_eq_check(node);
-			return;
+			return eval_eq_check(node);
 		case TYPE_NOT_EQUAL:
-			eval_not_eq_check(node);
-			return;
+			return eval_not_eq_check(node);
+		default:
+			return node;
 	}
 }
 
-// ########### PLUS ########### //
+// ########### OPERATOR TABLES ########### //
 
-void AST_Eval::eval_plus(std::shared_ptr<AST_Node>& node)
-{
-	eval(node->left);
-	eval(node->right);
+// Binary operators dispatch on the types of both operands through a [Type][Type] table of
+// handlers, built at compile time. Each operator's kernel is written once as a template and
+// instantiated for every pair of operand types it supports.
 
-	while (node->left->type == TYPE_VAR)
-	{
-		eval_var(node->left);
-	}
+// Fills in 'result', which starts out empty
+using Binary_Handler = void (*)(AST_Node& result, AST_Node& left, AST_Node& right);
 
-	while (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
+// Whether two values are equal, for both '==' and '!='
+using Equality_Handler = bool (*)(AST_Node& left, AST_Node& right);
 
-	//---- ERROR ----//
+template <typename Handler>
+struct Operator_Table
+{
+	Handler handlers[TYPE_COUNT][TYPE_COUNT] = {};
 
-	if (node->left->type == TYPE_ERROR || node->right->type == TYPE_ERROR)
+	constexpr void set(Type left, Type right, Handler handler)
 	{
-		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
+		handlers[left][right] = handler;
 	}
 
-	//---- INT ----//
-
-	// plus int, int
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value + node->right->INT.value;
-	}
-	// plus int, float
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->INT.value + node->right->FLOAT.value;
-	}
-	// plus int, bool
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_BOOL)
+	Handler find(Type left, Type right) const
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value + node->right->BOOL.value;
+		return handlers[left][right];
 	}
+};
 
-	//---- FLOAT ----//
+struct Binary_Table : Operator_Table<Binary_Handler> {};
 
-	// plus float, int
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
+// Int, float and bool operands, as the C++ values they hold
+template <Type T>
+static auto operand(AST_Node& node)
+{
+	if constexpr (T == TYPE_INT)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value + node->right->INT.value;
+		return node.INT.value;
 	}
-	// plus float, float
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
+	else if constexpr (T == TYPE_FLOAT)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value + node->right->FLOAT.value;
+		return node.FLOAT.value;
 	}
-	// plus float, bool
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_BOOL)
+	else
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value + node->right->BOOL.value;
+		return node.BOOL.value;
 	}
+}
 
-	//---- LIST ----//
+struct Add { template <typename L, typename R> static auto apply(L left, R right) { return left + right; } };
+struct Sub { template <typename L, typename R> static auto apply(L left, R right) { return left - right; } };
+struct Mul { template <typename L, typename R> static auto apply(L left, R right) { return left * right; } };
 
-	// plus list, list
-	else if (node->left->type == TYPE_LIST && node->right->type == TYPE_LIST)
+// Dividing an int always gives a float; a bool divided by an int or bool stays integral
+struct Div
+{
+	template <typename L, typename R>
+	static auto apply(L left, R right)
 	{
-		node->type = TYPE_LIST;
-		for (auto& item : node->left->LIST.items)
+		if constexpr (std::is_same_v<L, int64_t>)
 		{
-			node->LIST.items.push_back(item);
+			return (double)left / right;
 		}
-		for (auto& item : node->right->LIST.items)
+		else
 		{
-			node->LIST.items.push_back(item);
+			return left / right;
 		}
 	}
+};
 
-	//---- STRING ----//
+// Floating results are floats, everything else (bools included) is promoted to int
+template <typename Op, Type L, Type R>
+static void arithmetic(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	auto value = Op::apply(operand<L>(left), operand<R>(right));
 
-	// plus string, string
-	else if (node->left->type == TYPE_STRING && node->right->type == TYPE_STRING)
+	if constexpr (std::is_floating_point_v<decltype(value)>)
 	{
-		node->type = TYPE_STRING;
-		std::shared_ptr<std::string> string = std::make_shared<std::string>();
-		*string = node->left->STRING.value + node->right->STRING.value;
-		node->STRING.value = *string;
+		result.type = TYPE_FLOAT;
+		result.FLOAT.value = value;
 	}
+	else
+	{
+		result.type = TYPE_INT;
+		result.INT.value = value;
+	}
+}
 
-	//---- BOOL ----//
+template <typename Op, Type L>
+constexpr void set_arithmetic_row(Binary_Table& table)
+{
+	table.set(L, TYPE_INT, arithmetic<Op, L, TYPE_INT>);
+	table.set(L, TYPE_FLOAT, arithmetic<Op, L, TYPE_FLOAT>);
+	table.set(L, TYPE_BOOL, arithmetic<Op, L, TYPE_BOOL>);
+}
+
+template <typename Op>
+constexpr Binary_Table arithmetic_table()
+{
+	Binary_Table table;
+	set_arithmetic_row<Op, TYPE_INT>(table);
+	set_arithmetic_row<Op, TYPE_FLOAT>(table);
+	set_arithmetic_row<Op, TYPE_BOOL>(table);
+	return table;
+}
 
-	// plus bool, int
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_INT)
+// list + list
+static void concat_lists(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	result.retype(TYPE_LIST);
+	for (auto& item : left.LIST().items)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value + node->right->INT.value;
+		result.LIST().items.push_back(item);
 	}
-	// plus bool, float
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_FLOAT)
+	for (auto& item : right.LIST().items)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->BOOL.value + node->right->FLOAT.value;
+		result.LIST().items.push_back(item);
 	}
-	// plus bool, bool
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
+}
+
+// string + string
+static void concat_strings(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	result.retype(TYPE_STRING);
+	result.STRING().value = left.STRING().value + right.STRING().value;
+}
+
+// int - string drops that many characters from the front
+static void drop_front(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	result.retype(TYPE_STRING);
+
+	std::string& string = right.STRING().value;
+	if (left.INT.value > (int64_t)string.size())
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value + node->right->BOOL.value;
+		result.retype(TYPE_ERROR);
+		return;
 	}
 
-	else
+	result.STRING().value = string.substr(left.INT.value < 0 ? 0 : left.INT.value);
+}
+
+// string - int drops that many characters from the back
+static void drop_back(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	result.retype(TYPE_STRING);
+
+	std::string& string = left.STRING().value;
+	int64_t length = (int64_t)string.size() - right.INT.value;
+	if (length < 0)
 	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
+		result.retype(TYPE_ERROR);
+		return;
 	}
-}
 
-// ########### MINUS ########### //
+	result.STRING().value = string.substr(0, length);
+}
 
-void AST_Eval::eval_minus(std::shared_ptr<AST_Node>& node)
+// list * int, int * list and the same for strings repeat the sequence
+template <bool Count_On_Left>
+static void repeat_list(AST_Node& result, AST_Node& left, AST_Node& right)
 {
-	eval(node->left);
-	eval(node->right);
+	AST_Node& list = Count_On_Left ? right : left;
+	int64_t count = Count_On_Left ? left.INT.value : right.INT.value;
 
-	while (node->left->type == TYPE_VAR)
+	result.retype(TYPE_LIST);
+	for (int64_t i = 0; i < count; i++)
 	{
-		eval_var(node->left);
+		for (auto& item : list.LIST().items)
+		{
+			result.LIST().items.push_back(item);
+		}
 	}
+}
+
+template <bool Count_On_Left>
+static void repeat_string(AST_Node& result, AST_Node& left, AST_Node& right)
+{
+	std::string& string = Count_On_Left ? right.STRING().value : left.STRING().value;
+	int64_t count = Count_On_Left ? left.INT.value : right.INT.value;
 
-	while (node->right->type == TYPE_VAR)
+	result.retype(TYPE_STRING);
+	std::string repeated;
+	for (int64_t i = 0; i < count; i++)
 	{
-		eval_var(node->right);
+		repeated += string;
 	}
+	result.STRING().value = repeated;
+}
+
+static constexpr Binary_Table PLUS_TABLE = []()
+{
+	Binary_Table table = arithmetic_table<Add>();
+	table.set(TYPE_LIST, TYPE_LIST, concat_lists);
+	table.set(TYPE_STRING, TYPE_STRING, concat_strings);
+	return table;
+}();
+
+static constexpr Binary_Table MINUS_TABLE = []()
+{
+	Binary_Table table = arithmetic_table<Sub>();
+	table.set(TYPE_INT, TYPE_STRING, drop_front);
+	table.set(TYPE_STRING, TYPE_INT, drop_back);
+	return table;
+}();
+
+static constexpr Binary_Table MUL_TABLE = []()
+{
+	Binary_Table table = arithmetic_table<Mul>();
+	table.set(TYPE_INT, TYPE_LIST, repeat_list<true>);
+	table.set(TYPE_LIST, TYPE_INT, repeat_list<false>);
+	table.set(TYPE_INT, TYPE_STRING, repeat_string<true>);
+	table.set(TYPE_STRING, TYPE_INT, repeat_string<false>);
+	return table;
+}();
+
+static constexpr Binary_Table DIV_TABLE = arithmetic_table<Div>();
+
+template <Type L, Type R>
+static bool numbers_equal(AST_Node& left, AST_Node& right)
+{
+	return operand<L>(left) == operand<R>(right);
+}
+
+static bool strings_equal(AST_Node& left, AST_Node& right)
+{
+	return left.STRING().value == right.STRING().value;
+}
+
+// Lists are equal when they hold the very same items
+static bool lists_equal(AST_Node& left, AST_Node& right)
+{
+	auto& left_items = left.LIST().items;
+	auto& right_items = right.LIST().items;
+	return left_items == right_items;
+}
+
+static bool types_equal(AST_Node& left, AST_Node& right)
+{
+	return left.TYPE().id == right.TYPE().id;
+}
 
+// Pairs not listed are never equal
+static constexpr Operator_Table<Equality_Handler> EQUALITY_TABLE = []()
+{
+	Operator_Table<Equality_Handler> table;
+	table.set(TYPE_INT, TYPE_INT, numbers_equal<TYPE_INT, TYPE_INT>);
+	table.set(TYPE_INT, TYPE_FLOAT, numbers_equal<TYPE_INT, TYPE_FLOAT>);
+	table.set(TYPE_FLOAT, TYPE_INT, numbers_equal<TYPE_FLOAT, TYPE_INT>);
+	table.set(TYPE_FLOAT, TYPE_FLOAT, numbers_equal<TYPE_FLOAT, TYPE_FLOAT>);
+	table.set(TYPE_BOOL, TYPE_BOOL, numbers_equal<TYPE_BOOL, TYPE_BOOL>);
+	table.set(TYPE_STRING, TYPE_STRING, strings_equal);
+	table.set(TYPE_LIST, TYPE_LIST, lists_equal);
+	table.set(TYPE_TYPE, TYPE_TYPE, types_equal);
+	return table;
+}();
+
+std::shared_ptr<AST_Node> AST_Eval::apply_binary(const Binary_Table& table, std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
 	//---- ERROR ----//
 
-	if (node->left->type == TYPE_ERROR || node->right->type == TYPE_ERROR)
+	if (left->type == TYPE_ERROR || right->type == TYPE_ERROR)
 	{
 		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
+		return create_error(node);
 	}
 
-	//---- INT ----//
+	auto result = std::make_shared<AST_Node>(TYPE_EMPTY);
 
-	// minus int, int
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
+	Binary_Handler handler = table.find(left->type, right->type);
+	if (handler)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value - node->right->INT.value;
+		handler(*result, *left, *right);
 	}
-	// minus int, float
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
+	else
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->INT.value - node->right->FLOAT.value;
+		std::cout << "\n" << log_error(node, not_implemented_error(node->type, left, right));
+		result->type = TYPE_ERROR;
 	}
-	// minus int, string
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_STRING)
-	{
-		node->type = TYPE_STRING;
 
-		std::shared_ptr<std::string> string = std::make_shared<std::string>();
+	return result;
+}
 
-		int str_len = (node->right->STRING.value).size();
+static bool values_equal(AST_Node& left, AST_Node& right)
+{
+	Equality_Handler handler = EQUALITY_TABLE.find(left.type, right.type);
+	return handler && handler(left, right);
+}
 
-		if (node->left->INT.value > str_len)
-		{
-			node->type = TYPE_ERROR;
-			return;
-		}
+// ########### QUICKENING ########### //
 
-		for (int i = node->left->INT.value; i < str_len; i++)
-		{
-			*string = *string + (node->right->STRING.value)[i];
-		}
+// Kernels for quickened operators work on unboxed Values, and return false when the result
+// doesn't fit in one (an int wider than 48 bits)
+using Value_Handler = bool (*)(Value left, Value right, Value& result);
 
-		node->STRING.value = *string;
+// A specialized binary operator: its guard is the operand types, and it calls the kernel
+// for them directly
+struct Quick_Form
+{
+	Type op = TYPE_EMPTY;
+	Type left = TYPE_EMPTY;
+	Type right = TYPE_EMPTY;
+	Value_Handler handler = nullptr;
+};
+
+template <Type T>
+static auto value_operand(Value value)
+{
+	if constexpr (T == TYPE_INT)
+	{
+		return value.as_int();
 	}
-	// minus int, bool
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_BOOL)
+	else
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value - node->right->BOOL.value;
+		return value.as_float();
 	}
+}
 
-	//---- FLOAT ----//
+template <typename Op, Type L, Type R>
+static bool quick_arithmetic(Value left, Value right, Value& result)
+{
+	auto value = Op::apply(value_operand<L>(left), value_operand<R>(right));
 
-	// minus float, int
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
+	if constexpr (std::is_floating_point_v<decltype(value)>)
+	{
+		result = Value::from_float(value);
+		return true;
+	}
+	else
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value - node->right->INT.value;
+		result = Value::from_int(value);
+		return Value::fits_int(value);
 	}
-	// minus float, float
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
+}
+
+template <bool Equal, Type L, Type R>
+static bool quick_compare(Value left, Value right, Value& result)
+{
+	result = Value::from_bool((value_operand<L>(left) == value_operand<R>(right)) == Equal);
+	return true;
+}
+
+struct Quick_Forms
+{
+	Quick_Form forms[QUICK_COUNT] = {};
+
+	template <Type L, Type R>
+	constexpr void set_pair(Quick_Op add, Quick_Op sub, Quick_Op mul, Quick_Op div, Quick_Op equal, Quick_Op not_equal)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value - node->right->FLOAT.value;
+		forms[add] = { TYPE_PLUS, L, R, quick_arithmetic<Add, L, R> };
+		forms[sub] = { TYPE_MINUS, L, R, quick_arithmetic<Sub, L, R> };
+		forms[mul] = { TYPE_STAR, L, R, quick_arithmetic<Mul, L, R> };
+		forms[div] = { TYPE_SLASH, L, R, quick_arithmetic<Div, L, R> };
+		forms[equal] = { TYPE_EQ_EQ, L, R, quick_compare<true, L, R> };
+		forms[not_equal] = { TYPE_NOT_EQUAL, L, R, quick_compare<false, L, R> };
 	}
-	// minus float, bool
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_BOOL)
+};
+
+static constexpr Quick_Forms QUICK_FORMS = []()
+{
+	Quick_Forms quick;
+	quick.set_pair<TYPE_INT, TYPE_INT>(QUICK_ADD_INT_INT, QUICK_SUB_INT_INT, QUICK_MUL_INT_INT,
+		QUICK_DIV_INT_INT, QUICK_EQ_INT_INT, QUICK_NOT_EQ_INT_INT);
+	quick.set_pair<TYPE_FLOAT, TYPE_FLOAT>(QUICK_ADD_FLOAT_FLOAT, QUICK_SUB_FLOAT_FLOAT, QUICK_MUL_FLOAT_FLOAT,
+		QUICK_DIV_FLOAT_FLOAT, QUICK_EQ_FLOAT_FLOAT, QUICK_NOT_EQ_FLOAT_FLOAT);
+	return quick;
+}();
+
+// The specialized form for 'op' on these operands, or QUICK_NONE
+static Quick_Op quick_form(Type op, Type left, Type right)
+{
+	for (int form = QUICK_SLOT + 1; form < QUICK_COUNT; form++)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value - node->right->BOOL.value;
+		const Quick_Form& quick = QUICK_FORMS.forms[form];
+		if (quick.op == op && quick.left == left && quick.right == right)
+		{
+			return (Quick_Op)form;
+		}
 	}
 
-	//---- LIST ----//
+	return QUICK_NONE;
+}
 
-	//---- STRING ----//
+Quickening_Stats& quickening_stats()
+{
+	static Quickening_Stats stats;
+	return stats;
+}
 
-	// minus string, int
-	else if (node->left->type == TYPE_STRING && node->right->type == TYPE_INT)
+void AST_Eval::profile(AST_Node& node, Quick_Op form)
+{
+	if (!quicken || node.quick != QUICK_NONE)
 	{
-		node->type = TYPE_STRING;
+		return;
+	}
 
-		std::shared_ptr<std::string> string = std::make_shared<std::string>();
+	if (form == QUICK_NONE || (node.quick_hits > 0 && form != node.quick_candidate))
+	{
+		node.quick = QUICK_GENERIC;
+		return;
+	}
 
-		int str_len = (node->left->STRING.value).size() - node->right->INT.value;
+	node.quick_candidate = form;
+	if (++node.quick_hits >= QUICKEN_AFTER)
+	{
+		node.quick = form;
+		quickening_stats().quickened++;
+	}
+}
 
-		if (str_len < 0)
-		{
-			node->type = TYPE_ERROR;
-			return;
-		}
+void AST_Eval::deoptimize(AST_Node& node)
+{
+	node.quick = QUICK_GENERIC;
+	quickening_stats().deoptimized++;
+}
 
-		for (int i = 0; i < str_len; i++)
+std::shared_ptr<AST_Node> AST_Eval::eval_quick(std::shared_ptr<AST_Node>& node)
+{
+	if (node->quick == QUICK_SLOT)
+	{
+		if (auto slot = find_slot(node->ID()))
 		{
-			*string = *string + (node->left->STRING.value)[i];
+			return *slot;
 		}
 
-		node->STRING.value = *string;
+		deoptimize(*node);
+		return eval_id(node);
 	}
 
-	//---- BOOL ----//
+	std::shared_ptr<AST_Node> holder;
+	Value result = quick_value(node, holder);
+	return result.is_object() ? holder : to_node(result);
+}
 
-	// minus bool, int
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_INT)
+Value AST_Eval::eval_value(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& holder)
+{
+	if (node->quick == QUICK_SLOT)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value - node->right->INT.value;
+		if (auto slot = find_slot(node->ID()))
+		{
+			auto& var = (*slot)->VAR();
+			if (var.value.is_object())
+			{
+				holder = var.node;
+			}
+			return var.value;
+		}
 	}
-	// minus bool, float
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_FLOAT)
+	else if (node->quick > QUICK_SLOT)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->BOOL.value - node->right->FLOAT.value;
+		return quick_value(node, holder);
 	}
-	// minus bool, bool
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
+	else if (node->type == TYPE_INT || node->type == TYPE_FLOAT || node->type == TYPE_BOOL)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value - node->right->BOOL.value;
+		Value value = to_value(*node);
+		if (value.is_object())
+		{
+			holder = node;
+		}
+		return value;
 	}
 
-	else
+	holder = eval(node);
+
+	if (holder->type == TYPE_VAR)
 	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
+		auto& var = holder->VAR();
+		Value value = var.value;
+		holder = var.node;
+		return value;
 	}
 
+	return to_value(*holder);
 }
 
-// ########### MUL ########### //
-
-void AST_Eval::eval_mul(std::shared_ptr<AST_Node>& node)
+Value AST_Eval::quick_value(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& holder)
 {
-	eval(node->left);
-	eval(node->right);
+	const Quick_Form& form = QUICK_FORMS.forms[node->quick];
 
-	while (node->left->type == TYPE_VAR)
+	std::shared_ptr<AST_Node> left_holder, right_holder;
+	Value left = eval_value(node->left, left_holder);
+	Value right = eval_value(node->right, right_holder);
+
+	Value result;
+	if (left.type() != form.left || right.type() != form.right)
 	{
-		eval_var(node->left);
+		deoptimize(*node);
 	}
-
-	while (node->right->type == TYPE_VAR)
+	else if (!left.is_object() && !right.is_object() && form.handler(left, right, result))
 	{
-		eval_var(node->right);
+		return result;
 	}
 
-	//---- ERROR ----//
-
-	if (node->left->type == TYPE_ERROR || node->right->type == TYPE_ERROR)
-	{
-		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
-	}
-
-	//---- INT ----//
-
-	// mul int, int
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value * node->right->INT.value;
-	}
-	// mul int, float
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->INT.value * node->right->FLOAT.value;
-	}
-	// mul int, list
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_LIST)
-	{
-		node->type = TYPE_LIST;
-		for (int i = 0; i < node->left->INT.value; i++)
-		{
-			for (auto& item : node->right->LIST.items)
-			{
-				node->LIST.items.push_back(item);
-			}
-		}
-	}
-	// mul int, string
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_STRING)
-	{
-		node->type = TYPE_STRING;
-
-		std::shared_ptr<std::string> string = std::make_shared<std::string>();
-
-		for (int i = 0; i < node->left->INT.value; i++)
-		{
-			*string = *string + node->right->STRING.value;
-		}
-
-		node->STRING.value = *string;
-	}
-	// mul int, bool
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->INT.value * node->right->BOOL.value;
-	}
-
-	//---- FLOAT ----//
+	// The operands are already evaluated, so finish on the generic path with them. Wide ints
+	// get here too, without deoptimizing.
+	auto generic_left = left.is_object() ? left_holder : to_node(left);
+	auto generic_right = right.is_object() ? right_holder : to_node(right);
+	holder = apply_operator(node, generic_left, generic_right);
+	return to_value(*holder);
+}
 
-	// mul float, int
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value * node->right->INT.value;
-	}
-	// mul float, float
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value * node->right->FLOAT.value;
-	}
-	// mul float, bool
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value * node->right->BOOL.value;
-	}
+bool AST_Eval::eval_condition(std::shared_ptr<AST_Node>& node)
+{
+	std::shared_ptr<AST_Node> holder;
+	Value value = eval_value(node, holder);
 
-	//---- LIST ----//
+	// Only a true bool is true; any other value's BOOL is false
+	return value.is_object() ? holder->BOOL.value : value.is_bool() && value.as_bool();
+}
 
-	// mul list, int
-	else if (node->left->type == TYPE_LIST && node->right->type == TYPE_INT)
+std::shared_ptr<AST_Node> AST_Eval::apply_operator(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	switch (node->type)
 	{
-		node->type = TYPE_LIST;
-		for (int i = 0; i < node->right->INT.value; i++)
-		{
-			for (auto& item : node->left->LIST.items)
-			{
-				node->LIST.items.push_back(item);
-			}
-		}
+		case TYPE_PLUS:
+			return apply_plus(node, left, right);
+		case TYPE_MINUS:
+			return apply_minus(node, left, right);
+		case TYPE_STAR:
+			return apply_mul(node, left, right);
+		case TYPE_SLASH:
+			return apply_div(node, left, right);
+		case TYPE_EQ_EQ:
+			return apply_eq_check(node, left, right);
+		default:
+			return apply_not_eq_check(node, left, right);
 	}
-	//---- STRING ----//
-
-	// mul string, int
-	else if (node->left->type == TYPE_STRING && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_STRING;
-
-		std::shared_ptr<std::string> string = std::make_shared<std::string>();
+}
 
-		for (int i = 0; i < node->right->INT.value; i++)
-		{
-			*string = *string + node->left->STRING.value;
-		}
+// ########### PLUS ########### //
 
-		node->STRING.value = *string;
-	}
+std::shared_ptr<AST_Node> AST_Eval::eval_plus(std::shared_ptr<AST_Node>& node)
+{
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	//---- BOOL ----//
+	eval_var(left);
+	eval_var(right);
 
-	// mul bool, int
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value * node->right->INT.value;
-	}
-	// mul bool, float
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->BOOL.value * node->right->FLOAT.value;
-	}
-	// mul bool, bool
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value * node->right->BOOL.value;
-	}
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_plus(node, left, right);
+}
 
-	else
-	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
-	}
+std::shared_ptr<AST_Node> AST_Eval::apply_plus(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	return apply_binary(PLUS_TABLE, node, left, right);
 }
 
-// ########### DIV ########### //
+// ########### MINUS ########### //
 
-void AST_Eval::eval_div(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_minus(std::shared_ptr<AST_Node>& node)
 {
-	eval(node->left);
-	eval(node->right);
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	while (node->left->type == TYPE_VAR)
-	{
-		eval_var(node->left);
-	}
+	eval_var(left);
+	eval_var(right);
 
-	while (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_minus(node, left, right);
+}
 
-	//---- ERROR ----//
+std::shared_ptr<AST_Node> AST_Eval::apply_minus(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	return apply_binary(MINUS_TABLE, node, left, right);
+}
 
-	if (node->left->type == TYPE_ERROR || node->right->type == TYPE_ERROR)
-	{
-		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
-	}
+// ########### MUL ########### //
 
-	//---- INT ----//
+std::shared_ptr<AST_Node> AST_Eval::eval_mul(std::shared_ptr<AST_Node>& node)
+{
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	// div int, int
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = (float)node->left->INT.value / (float)node->right->INT.value;
-	}
-	// div int, float
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = (float)node->left->INT.value / node->right->FLOAT.value;
-	}
-	// div int, bool
-	else if (node->left->type == TYPE_INT && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = (float)node->left->INT.value / node->right->BOOL.value;
-	}
+	eval_var(left);
+	eval_var(right);
 
-	//---- FLOAT ----//
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_mul(node, left, right);
+}
 
-	// div float, int
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value / node->right->INT.value;
-	}
-	// div float, float
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value / node->right->FLOAT.value;
-	}
-	// div float, bool
-	else if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->FLOAT.value / node->right->BOOL.value;
-	}
+std::shared_ptr<AST_Node> AST_Eval::apply_mul(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	return apply_binary(MUL_TABLE, node, left, right);
+}
 
-	//---- LIST ----//
+// ########### DIV ########### //
 
-	//---- STRING ----//
+std::shared_ptr<AST_Node> AST_Eval::eval_div(std::shared_ptr<AST_Node>& node)
+{
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	//---- BOOL ----//
+	eval_var(left);
+	eval_var(right);
 
-	// div bool, int
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_INT)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value / node->right->INT.value;
-	}
-	// div bool, float
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_FLOAT)
-	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = node->left->BOOL.value / node->right->FLOAT.value;
-	}
-	// div bool, bool
-	else if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->left->BOOL.value / node->right->BOOL.value;
-	}
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_div(node, left, right);
+}
 
-	else
-	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
-	}
+std::shared_ptr<AST_Node> AST_Eval::apply_div(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	return apply_binary(DIV_TABLE, node, left, right);
 }
 
 // ########### NEG ########### //
 
-void AST_Eval::eval_neg(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_neg(std::shared_ptr<AST_Node>& node)
 {
-	eval(node->right);
+	auto right = eval(node->right);
 
-	while (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
+	eval_var(right);
 
+	return apply_neg(node, right);
+}
+
+std::shared_ptr<AST_Node> AST_Eval::apply_neg(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& right)
+{
 	//---- ERROR ----//
 
-	if (node->right->type == TYPE_ERROR)
+	if (right->type == TYPE_ERROR)
 	{
 		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
+		return create_error(node);
 	}
 
+	auto result = std::make_shared<AST_Node>(TYPE_EMPTY);
+
 	//---- INT ----//
 
 	// neg int
-	if (node->right->type == TYPE_INT)
+	if (right->type == TYPE_INT)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = -node->right->INT.value;
+		result->type = TYPE_INT;
+		result->INT.value = -right->INT.value;
 	}
 	// neg float
-	else if (node->right->type == TYPE_FLOAT)
+	else if (right->type == TYPE_FLOAT)
 	{
-		node->type = TYPE_FLOAT;
-		node->FLOAT.value = -node->right->FLOAT.value;
+		result->type = TYPE_FLOAT;
+		result->FLOAT.value = -right->FLOAT.value;
 	}
 	// neg list
-	else if (node->right->type == TYPE_LIST)
+	else if (right->type == TYPE_LIST)
 	{
-		node->type = TYPE_LIST;
+		result->retype(TYPE_LIST);
 
-		for (int i = node->right->LIST.items.size() - 1; i > 0; i--)
+		for (int i = right->LIST().items.size() - 1; i > 0; i--)
 		{
-			node->LIST.items.push_back(node->right->LIST.items[i]);
+			result->LIST().items.push_back(right->LIST().items[i]);
 		}
 	}
 	// neg string
-	else if (node->right->type == TYPE_STRING)
+	else if (right->type == TYPE_STRING)
 	{
-		node->type = TYPE_STRING;
+		result->retype(TYPE_STRING);
 		std::shared_ptr<std::string> string = std::make_shared<std::string>();
 
-		for (int i = (node->right->STRING.value).length() - 1; i >= 0; i--)
+		for (int i = (right->STRING().value).length() - 1; i >= 0; i--)
 		{
-			*string = *string + (node->right->STRING.value)[i];
+			*string = *string + (right->STRING().value)[i];
 		}
 
-		node->STRING.value = *string;
+		result->STRING().value = *string;
 	}
 	// neg bool
-	else if (node->right->type == TYPE_BOOL)
+	else if (right->type == TYPE_BOOL)
 	{
-		node->type = TYPE_INT;
-		node->INT.value = -(int)(node->right->BOOL.value);
+		result->type = TYPE_INT;
+		result->INT.value = -(int64_t)(right->BOOL.value);
 	}
 
 	else
 	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
+		std::cout << "\n" << log_error(node, not_implemented_error(node->type, nullptr, right));
+		result->type = TYPE_ERROR;
 	}
+
+	return result;
 }
 
 // ########### POS ########### //
 
-void AST_Eval::eval_pos(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_pos(std::shared_ptr<AST_Node>& node)
 {
-	eval(node->right);
+	auto right = eval(node->right);
 
-	while (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
+	eval_var(right);
+
+	return apply_pos(node, right);
+}
 
+std::shared_ptr<AST_Node> AST_Eval::apply_pos(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& right)
+{
 	//---- ERROR ----//
 
-	if (node->right->type == TYPE_ERROR)
+	if (right->type == TYPE_ERROR)
 	{
 		std::cout << "\n" << log_error(node, "Malformed '" + type_repr(node->type) + "' statement.");
-		node->type = TYPE_ERROR;
-		return;
+		return create_error(node);
 	}
 
+	auto result = std::make_shared<AST_Node>(TYPE_EMPTY);
+
 	//---- INT ----//
 
 	// pos int
-	if (node->right->type == TYPE_INT)
+	if (right->type == TYPE_INT)
 	{
-		return;
+		return right;
 	}
 	// pos float
-	else if (node->right->type == TYPE_FLOAT)
+	else if (right->type == TYPE_FLOAT)
 	{
-		return;
+		return right;
 	}
 	// pos list
-	else if (node->right->type == TYPE_LIST)
+	else if (right->type == TYPE_LIST)
 	{
-		return;
+		return right;
 	}
 	// pos string
-	else if (node->right->type == TYPE_STRING)
+	else if (right->type == TYPE_STRING)
 	{
-		return;
+		return right;
 	}
 	// pos bool
-	else if (node->right->type == TYPE_BOOL)
-	{
-		node->type = TYPE_INT;
-		node->INT.value = node->BOOL.value;
-	}
-
-	else
-	{
-		std::cout << "\n" << log_error(node, not_implemented_error(node));
-		node->type = TYPE_ERROR;
-	}
-}
-
-// ########### EQ ########### //
-
-void AST_Eval::eval_eq_check(std::shared_ptr<AST_Node>& node)
-{
-	eval(node->left);
-	eval(node->right);
-
-	if (node->left->type == TYPE_VAR)
-	{
-		eval_var(node->left);
-	}
-
-	if (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
-
-	node->type = TYPE_BOOL;
-
-	//---- INT ----//
-
-	// int, int
-
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
-	{
-		if (node->left->INT.value == node->right->INT.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	// int, float
-
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
-	{
-		if (node->left->INT.value == node->right->FLOAT.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	//---- FLOAT ----//
-
-	// float, int
-
-	if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
-	{
-		if (node->left->FLOAT.value == node->right->INT.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	// float, float
-
-	if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
-	{
-		if (node->left->FLOAT.value == node->right->FLOAT.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	//---- BOOL ----//
-
-	// bool, bool
-
-	if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
-	{
-		if (node->left->BOOL.value == node->right->BOOL.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	//---- STRING ----//
-
-	// string, string
-
-	if (node->left->type == TYPE_STRING && node->right->type == TYPE_STRING)
-	{
-		if (node->left->STRING.value == node->right->STRING.value)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-
-	//---- LIST ----//
-
-	// list, list
-
-	if (node->left->type == TYPE_LIST && node->right->type == TYPE_LIST)
-	{
-		if (node->left->LIST.items.size() != node->right->LIST.items.size())
-		{
-			node->BOOL.value = false;
-			return;
-		}
-
-		auto left_items = node->left->LIST.items;
-		auto right_items = node->right->LIST.items;
-
-		for (int i = 0; i < left_items.size(); i++)
-		{
-			if (left_items[i] != right_items[i])
-			{
-				node->BOOL.value = false;
-				return;
-			}
-		}
-
-		node->BOOL.value = true;
-		return;
-	}
-
-	//---- TYPE ----//
-
-	// type, type
-
-	if (node->left->type == TYPE_TYPE && node->right->type == TYPE_TYPE)
-	{
-		if (node->left->TYPE.name == node->right->TYPE.name)
-		{
-			node->BOOL.value = true;
-		}
-		else
-		{
-			node->BOOL.value = false;
-		}
-
-		return;
-	}
-
-	node->BOOL.value = false;
-}
-
-// ########### NOT EQ ########### //
-
-void AST_Eval::eval_not_eq_check(std::shared_ptr<AST_Node>& node)
-{
-	eval(node->left);
-	eval(node->right);
-
-	if (node->left->type == TYPE_VAR)
-	{
-		eval_var(node->left);
-	}
-
-	if (node->right->type == TYPE_VAR)
-	{
-		eval_var(node->right);
-	}
-
-	node->type = TYPE_BOOL;
-
-	//---- INT ----//
-
-	// int, int
-
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_INT)
-	{
-		if (node->left->INT.value == node->right->INT.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
-
-		return;
-	}
-
-	// int, float
-
-	if (node->left->type == TYPE_INT && node->right->type == TYPE_FLOAT)
-	{
-		if (node->left->INT.value == node->right->FLOAT.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
-
-		return;
+	else if (right->type == TYPE_BOOL)
+	{
+		result->type = TYPE_INT;
+		result->INT.value = right->BOOL.value;
 	}
 
-	//---- FLOAT ----//
+	else
+	{
+		std::cout << "\n" << log_error(node, not_implemented_error(node->type, nullptr, right));
+		result->type = TYPE_ERROR;
+	}
 
-	// float, int
+	return result;
+}
 
-	if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_INT)
-	{
-		if (node->left->FLOAT.value == node->right->INT.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
+// ########### EQ ########### //
 
-		return;
-	}
+std::shared_ptr<AST_Node> AST_Eval::eval_eq_check(std::shared_ptr<AST_Node>& node)
+{
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	// float, float
+	eval_var(left);
+	eval_var(right);
 
-	if (node->left->type == TYPE_FLOAT && node->right->type == TYPE_FLOAT)
-	{
-		if (node->left->FLOAT.value == node->right->FLOAT.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_eq_check(node, left, right);
+}
 
-		return;
-	}
+std::shared_ptr<AST_Node> AST_Eval::apply_eq_check(std::shared_ptr<AST_Node>&, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	auto result = std::make_shared<AST_Node>(TYPE_BOOL);
+	result->BOOL.value = values_equal(*left, *right);
+	return result;
+}
 
-	//---- BOOL ----//
+// ########### NOT EQ ########### //
 
-	// bool, bool
+std::shared_ptr<AST_Node> AST_Eval::eval_not_eq_check(std::shared_ptr<AST_Node>& node)
+{
+	auto left = eval(node->left);
+	auto right = eval(node->right);
 
-	if (node->left->type == TYPE_BOOL && node->right->type == TYPE_BOOL)
-	{
-		if (node->left->BOOL.value == node->right->BOOL.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
+	eval_var(left);
+	eval_var(right);
 
-		return;
-	}
+	profile(*node, quick_form(node->type, left->type, right->type));
+	return apply_not_eq_check(node, left, right);
+}
 
-	//---- STRING ----//
+std::shared_ptr<AST_Node> AST_Eval::apply_not_eq_check(std::shared_ptr<AST_Node>&, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right)
+{
+	auto result = std::make_shared<AST_Node>(TYPE_BOOL);
+	result->BOOL.value = !values_equal(*left, *right);
+	return result;
+}
 
-	// string, string
+// ########### ASSIGNMENT ########### //
 
-	if (node->left->type == TYPE_STRING && node->right->type == TYPE_STRING)
+std::shared_ptr<AST_Node> AST_Eval::eval_assignment(std::shared_ptr<AST_Node>& node)
+{
+	if (node->left->type == TYPE_ID && node->right->quick >= QUICK_SLOT)
 	{
-		if (node->left->STRING.value == node->right->STRING.value)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
-
-		return;
+		return assign_value(node);
 	}
 
+	auto right = eval(node->right);
 
-	//---- LIST ----//
+	if (right->type == TYPE_ERROR)
+	{
+		return create_error(node);
+	}
 
-	// list, list
+	std::shared_ptr<AST_Node> var = nullptr;
 
-	if (node->left->type == TYPE_LIST && node->right->type == TYPE_LIST)
+	if (node->left->type == TYPE_DOUBLE_COLON)
 	{
-		if (node->left->LIST.items.size() != node->right->LIST.items.size())
-		{
-			node->BOOL.value = true;
-			return;
-		}
+		var = eval_scope_accessor(node->left);
 
-		auto left_items = node->left->LIST.items;
-		auto right_items = node->right->LIST.items;
-
-		for (int i = 0; i < left_items.size(); i++)
+		if (var->type != TYPE_VAR)
 		{
-			if (left_items[i] != right_items[i])
-			{
-				node->BOOL.value = true;
-				return;
-			}
+			return create_error(node);
 		}
-
-		node->BOOL.value = false;
-		return;
 	}
+	else if (node->left->type == TYPE_ID)
+	{
+		var = get_data(node->left->ID());
+	}
+	else
+	{
+		return node;
+	}
+
+	return store(node, var, right);
+}
 
-	//---- TYPE ----//
+std::shared_ptr<AST_Node> AST_Eval::assign_value(std::shared_ptr<AST_Node>& node)
+{
+	std::shared_ptr<AST_Node> holder;
+	Value value = eval_value(node->right, holder);
 
-	// type, type
+	auto var = get_data(node->left->ID());
 
-	if (node->left->type == TYPE_TYPE && node->right->type == TYPE_TYPE)
+	// Same type as before, so there's nothing to check
+	if (!value.is_object() && var && var->VAR().type == value_type_id(value.type()))
 	{
-		if (node->left->TYPE.name == node->right->TYPE.name)
-		{
-			node->BOOL.value = false;
-		}
-		else
-		{
-			node->BOOL.value = true;
-		}
+		var->VAR().set(value);
+		return var;
+	}
 
-		return;
+	auto right = value.is_object() ? holder : to_node(value);
+
+	if (right->type == TYPE_ERROR)
+	{
+		return create_error(node);
 	}
 
-	node->BOOL.value = true;
+	return store(node, var, right);
 }
 
-// ########### ASSIGNMENT ########### //
-
-void AST_Eval::eval_assignment(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::store(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& var, std::shared_ptr<AST_Node> right)
 {
-	eval(node->right);
-
-	if (node->right->type == TYPE_ERROR)
+	if (!var)
 	{
-		node->type = TYPE_ERROR;
-		return;
+		var = std::make_shared<AST_Node>(TYPE_VAR);
+		var->VAR().symbol = node->left->ID().symbol;
+		var->VAR().set(right);
+		var->VAR().type = infer_type_id(right);
+		add_data_to_scope(var, current_scope, node->left->ID());
+		return right;
 	}
 
-	if (node->left->type == TYPE_DOUBLE_COLON)
+	// do type_check
+	int right_type = infer_type_id(right);
+	if (var->VAR().type == right_type)
+	{
+		var->VAR().set(right);
+	}
+	else
 	{
-		eval_scope_accessor(node->left);
+		int impl_cast = implicit_cast(right, var->VAR().type);
 
-		// do type_check
-		auto right_type = infer_type(node->right);
-		if (node->left->VAR.type->TYPE.name == right_type->TYPE.name)
-		{
-			node->left->VAR.value = node->right;
-			node->left->VAR.type = right_type;
-		}
-		else
+		if (impl_cast == CAST_OK)
 		{
-			int impl_cast = implicit_cast(node->right, node->left->VAR.type->TYPE.name);
-
-			if (impl_cast == 0)
-			{
-				node->left->VAR.value = node->right;
-				node->left->VAR.type = infer_type(node->right);
-			}
-			else if (impl_cast == 1)
-			{
-				node->left->VAR.value = node->right;
-				node->left->VAR.type = infer_type(node->right);
-				std::cout << "\n" << "Warning: Potential data loss...";
-			}
-			else
-			{
-				std::cout << "\n" << log_error(node, "Cannot assign value of type '" + right_type->TYPE.name + "' to variable of type '" + node->left->VAR.type->TYPE.name + "'.");
-				node->type = TYPE_ERROR;
-				return;
-			}
+			var->VAR().set(right);
+			var->VAR().type = infer_type_id(right);
 		}
-
-	}
-
-	else if (node->left->type == TYPE_ID)
-	{
-		std::shared_ptr<AST_Node> var = get_data(node->left->ID.value);
-		if (var)
+		else if (impl_cast == CAST_DATA_LOSS)
 		{
-			// do type_check
-			auto right_type = infer_type(node->right);
-			if (var->VAR.type->TYPE.name == right_type->TYPE.name)
-			{
-				var->VAR.value = node->right;
-				var->VAR.type = right_type;
-			}
-			else
-			{
-				int impl_cast = implicit_cast(node->right, var->VAR.type->TYPE.name);
-
-				if (impl_cast == 0)
-				{
-					var->VAR.value = node->right;
-					var->VAR.type = infer_type(node->right);
-				}
-				else if (impl_cast == 1)
-				{
-					var->VAR.value = node->right;
-					var->VAR.type = infer_type(node->right);
-					std::cout << "\n" << "Warning: Potential data loss...";
-				}
-				else
-				{
-					std::cout << "\n" << log_error(node, "Cannot assign value of type '" + right_type->TYPE.name + "' to variable of type '" + var->VAR.type->TYPE.name + "'.");
-					node->type = TYPE_ERROR;
-					return;
-				}
-			}
+			var->VAR().set(right);
+			var->VAR().type = infer_type_id(right);
+			std::cout << "\n" << "Warning: Potential data loss...";
 		}
 		else
 		{
-			var = std::make_shared<AST_Node>(TYPE_VAR);
-			var->VAR.name = node->left->ID.value;
-			var->VAR.value = node->right;
-			var->VAR.type = infer_type(node->right);
-			current_scope->SCOPE.data.push_back(var);
+			std::cout << "\n" << log_error(node, "Cannot assign value of type '" + type_name(right_type) + "' to variable of type '" + type_name(var->VAR().type) + "'.");
+			return create_error(node);
 		}
 	}
+
+	return right;
 }
 
 // ########### BLOCK ########### //
 
-void AST_Eval::eval_block(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_block(std::shared_ptr<AST_Node>& node)
 {
 	std::shared_ptr<AST_Node> scope;
 
-	if (node->BLOCK.name.empty())
+	if (node->BLOCK().name.empty())
 	{
-		scope = new_scope();
+		scope = new_scope("", node->BLOCK().slots);
 	}
 	else
 	{
-		scope = new_scope(node->BLOCK.name);
+		scope = new_scope(node->BLOCK().name, node->BLOCK().slots);
 	}
 
 	enter_scope(scope);
 
-	for (auto& expr : node->BLOCK.body)
+	for (auto& expr : node->BLOCK().body)
 	{
-		eval(expr);
+		auto result = eval(expr);
+
+		if (is_control(result))
+		{
+			exit_scope();
+			return result;
+		}
 	}
 
 	exit_scope();
+
+	return empty;
 }
 
 // ########### DOUBLE_COLON ########### //
 
-void AST_Eval::eval_scope_accessor(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_scope_accessor(std::shared_ptr<AST_Node>& node)
 {
 	std::shared_ptr<AST_Node> scope = nullptr;
 
 	if (node->left->type == TYPE_ID)
 	{
-		auto data = get_data(node->left->ID.value);
-		scope = data->VAR.value;
+		auto data = get_data(node->left->ID());
+		if (data)
+		{
+			scope = data->VAR().get();
+		}
 	}
 	else if (node->left->type == TYPE_DOUBLE_COLON)
 	{
-		eval_scope_accessor(node->left);
-		scope = node->left;
+		scope = eval_scope_accessor(node->left);
 	}
 	else if (node->left->type == TYPE_CALL)
 	{
-		eval_call(node->left);
-		scope = node->left;
+		scope = eval_call(node->left);
 	}
 
-	if (!scope)
+	return access_scope(node, scope);
+}
+
+std::shared_ptr<AST_Node> AST_Eval::access_scope(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node> scope)
+{
+	// Either side may be something other than a name, like the '5' in 'a::5'
+	auto scope_name = node->left->find_payload<ID_Node>();
+	auto name = node->right->find_payload<ID_Node>();
+
+	if (!scope || scope->type == TYPE_ERROR)
 	{
-		std::cout << "\n" << log_error(node, "Scope '" + node->left->ID.value + "' is not defined in current or outer scopes.");
-		node->type = TYPE_ERROR;
-		return;
+		std::cout << "\n" << log_error(node, "Scope '" + (scope_name ? scope_name->value : "") + "' is not defined in current or outer scopes.");
+		return create_error(node);
 	}
 
 	if (scope->type == TYPE_VAR)
 	{
-		scope = scope->VAR.value;
+		scope = scope->VAR().get();
 	}
 
-	std::shared_ptr<AST_Node> var = get_data_from_scope(node->right->ID.value, scope);
-
-	if (var)
-	{
-		node = var;
-		return;
-	}
+	std::shared_ptr<AST_Node> var = get_data_from_scope(name ? name->value : "", scope);
 
 	if (!var)
 	{
-		std::cout << "\n" << log_error(node, "'" + node->right->ID.value + "' is not defined in scope '" +
-			scope->SCOPE.name + "'.");
-		node->type = TYPE_ERROR;
-		return;
+		auto scope_node = scope->find_payload<Scope_Node>();
+		std::cout << "\n" << log_error(node, "'" + (name ? name->value : "") + "' is not defined in scope '" +
+			(scope_node ? scope_node->name : "") + "'.");
+		return create_error(node);
 	}
+
+	return var;
 }
 
 // ########### SCOPE ########### //
 
-std::shared_ptr<AST_Node> AST_Eval::new_scope(std::string name)
+std::shared_ptr<AST_Node> AST_Eval::new_scope(std::string name, int slots)
 {
 	__scopes_num++;
 	std::shared_ptr<AST_Node> scope = std::make_shared<AST_Node>(TYPE_SCOPE);
 	if (name.length() == 0)
 	{
-		scope->SCOPE.name = std::to_string(__scopes_num);
+		scope->SCOPE().name = std::to_string(__scopes_num);
 	}
 	else
 	{
-		scope->SCOPE.is_named = true;
-		scope->SCOPE.name = name;
+		scope->SCOPE().is_named = true;
+		scope->SCOPE().name = name;
 	}
 
-	scope->SCOPE.parent = current_scope;
+	scope->SCOPE().parent = current_scope;
+	scope->SCOPE().slots.resize(slots);
 
 	std::shared_ptr<AST_Node> scope_var = std::make_shared<AST_Node>(TYPE_VAR);
-	scope_var->VAR.value = scope;
-	scope_var->VAR.name = scope->SCOPE.name;
-	std::shared_ptr<AST_Node> scope_var_type = std::make_shared<AST_Node>(TYPE_TYPE);
-	scope_var_type->TYPE.name = "scope";
-	scope_var->VAR.type = scope_var_type;
+	scope_var->VAR().set(scope);
+	if (scope->SCOPE().is_named)
+	{
+		scope_var->VAR().symbol = intern(scope->SCOPE().name);
+	}
+	scope_var->VAR().type = TID_SCOPE;
+
+	// Unnamed scopes get a fresh number and can't be referred to by name, so they stay out of the index
+	if (scope->SCOPE().is_named)
+	{
+		add_data_to_scope(scope_var, current_scope);
+	}
+	else
+	{
+		current_scope->SCOPE().data.push_back(scope_var);
+	}
 
-	current_scope->SCOPE.data.push_back(scope_var);
 	return scope;
 }
 
 void AST_Eval::enter_scope(std::shared_ptr<AST_Node>& scope)
 {
+	scope->SCOPE().activation = ++activations;
 	current_scope = scope;
 }
 
 void AST_Eval::clear_scope(std::shared_ptr<AST_Node>& scope)
 {
-	scope->SCOPE.data.clear();
+	scope->SCOPE().data.clear();
+	scope->SCOPE().index.clear();
+	scope->SCOPE().slots.clear();
 }
 
 void AST_Eval::delete_scope(std::shared_ptr<AST_Node>& scope)
 {
-	auto& data = scope->SCOPE.parent->SCOPE.data;
+	auto& parent = scope->SCOPE().parent->SCOPE();
 
-	for (int i = 0; i < data.size(); i++)
+	// The parent holds the scope through its scope var, usually the most recent entry
+	for (int i = parent.data.size() - 1; i >= 0; i--)
 	{
-		if (data[i] == scope)
+		if (parent.data[i]->VAR().node == scope)
 		{
-			data.erase(data.begin() + i);
+			auto entry = parent.index.find(parent.data[i]->VAR().symbol);
+			if (entry != parent.index.end() && entry->second == parent.data[i])
+			{
+				parent.index.erase(entry);
+			}
+
+			parent.data.erase(parent.data.begin() + i);
 			return;
 		}
 	}
 }
 
+void AST_Eval::push_frame(Func_Def_Node& func)
+{
+	if (call_depth == frames.size())
+	{
+		frames.emplace_back();
+	}
+
+	auto& frame = frames[call_depth++];
+
+	// Still held from an earlier call, e.g. by a VM inline cache
+	if (!frame || frame.use_count() > 1)
+	{
+		frame = std::make_shared<AST_Node>(TYPE_SCOPE);
+		frame->SCOPE().name = std::to_string(++__scopes_num);
+		frames_allocated++;
+	}
+
+	auto& scope = frame->SCOPE();
+	scope.parent = current_scope;
+	scope.slots.resize(func.slots);
+	scope.params.resize(func.params.size());
+
+	enter_scope(frame);
+}
+
+Var_Node& AST_Eval::param_var(Func_Def_Node& func, int index)
+{
+	// A param that isn't a name, like the '5' in 'def f(a, 5)', binds a var nothing can look up
+	auto param = func.params[index]->find_payload<ID_Node>();
+	auto& var = current_scope->SCOPE().params[index];
+
+	// A var that outlived its call, e.g. returned by it, can't be reused
+	if (!var || var.use_count() > 1)
+	{
+		var = std::make_shared<AST_Node>(TYPE_VAR);
+	}
+
+	if (param && param->depth == 0)
+	{
+		current_scope->SCOPE().slots[param->slot] = var;
+	}
+
+	var->VAR().symbol = param ? param->symbol : -1;
+	return var->VAR();
+}
+
+void AST_Eval::bind_param(Func_Def_Node& func, int index, Value value)
+{
+	auto& var = param_var(func, index);
+	var.set(value);
+	var.type = value_type_id(value.type());
+}
+
+void AST_Eval::bind_param(Func_Def_Node& func, int index, std::shared_ptr<AST_Node>& value)
+{
+	auto& var = param_var(func, index);
+	var.set(value);
+	var.type = infer_type_id(value);
+}
+
+void AST_Eval::pop_frame()
+{
+	auto& scope = current_scope->SCOPE();
+
+	// Params stay in 'params' for the next call at this depth to reuse
+	scope.data.clear();
+	scope.index.clear();
+	std::fill(scope.slots.begin(), scope.slots.end(), nullptr);
+
+	call_depth--;
+	current_scope = scope.parent;
+
+	// A frame nothing else kept lets go of the caller's scope, so the caller's frame can be reused too
+	if (frames[call_depth].use_count() == 1)
+	{
+		scope.parent = nullptr;
+	}
+}
+
 void AST_Eval::exit_scope()
 {
-	if (!current_scope->SCOPE.is_named)
+	if (!current_scope->SCOPE().is_named)
 	{
 		clear_scope(current_scope);
 		delete_scope(current_scope);
 	}
-	current_scope = current_scope->SCOPE.parent;
+	current_scope = current_scope->SCOPE().parent;
 }
 
 // ########### ID ########### //
 
-void AST_Eval::eval_id(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_id(std::shared_ptr<AST_Node>& node)
 {
-	std::shared_ptr<AST_Node> var = get_data(node->ID.value);
-
-	if (!var)
+	if (auto slot = find_slot(node->ID()))
 	{
-		std::cout << "\n" << log_error(node, "Variable '" + node->ID.value + "' is not defined.");
-		node->type = TYPE_ERROR;
-		return;
+		profile(*node, QUICK_SLOT);
+		return *slot;
 	}
-	else
+
+	std::shared_ptr<AST_Node> var = get_data(node->ID().symbol);
+
+	if (!var)
 	{
-		node = var;
-		return;
+		std::cout << "\n" << log_error(node, "Variable '" + node->ID().value + "' is not defined.");
+		return create_error(node);
 	}
 
-	return;
+	return var;
 }
 
 void AST_Eval::eval_var(std::shared_ptr<AST_Node>& node)
 {
-	while (node->type == TYPE_VAR)
+	if (node->type == TYPE_VAR)
 	{
-		eval(node->VAR.value);
-		node = node->VAR.value;
+		node = node->VAR().get();
 	}
-	return;
 }
 
 // ########### IF/ELSE ########### //
 
-void AST_Eval::eval_if_else(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_if_else(std::shared_ptr<AST_Node>& node)
 {
-	for (auto if_stmnt : node->IF_STATEMENT.statements)
+	for (auto& if_stmnt : node->IF_STATEMENT().statements)
 	{
-		eval(if_stmnt->IF.expr);
-
-		if (if_stmnt->IF.expr->type == TYPE_VAR)
+		if (if_stmnt->type != TYPE_ELSE && !eval_condition(if_stmnt->IF().expr))
 		{
-			eval_var(if_stmnt->IF.expr);
+			continue;
 		}
 
-		if (if_stmnt->type == TYPE_ELSE)
+		for (auto& expr : if_stmnt->IF().body->BLOCK().body)
 		{
-			for (auto expr : if_stmnt->IF.body->BLOCK.body)
-			{
-				auto expr_copy = deep_copy(expr);
-
-				eval(expr_copy);
-
-				if (expr_copy->type == TYPE_BREAK || expr_copy->type == TYPE_BREAK_ALL)
-				{
-					node->type = TYPE_BREAK_ALL;
-					return;
-				}
+			auto result = eval(expr);
 
-				return;
-			}
-		}
-
-		if (if_stmnt->IF.expr->BOOL.value == true)
-		{
-			for (auto expr : if_stmnt->IF.body->BLOCK.body)
+			if (is_control(result))
 			{
-				auto expr_copy = deep_copy(expr);
-
-				eval(expr_copy);
-
-				if (expr_copy->type == TYPE_BREAK || expr_copy->type == TYPE_BREAK_ALL)
-				{
-					node->type = TYPE_BREAK_ALL;
-					return;
-				}
-
-				return;
+				return result;
 			}
 		}
-		else
-		{
-			continue;
-		}
+
+		return empty;
 	}
+
+	return empty;
 }
 
 // ########### WHILE ########### //
 
-void AST_Eval::eval_while(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_while(std::shared_ptr<AST_Node>& node)
 {
-	std::shared_ptr<AST_Node> while_expr = deep_copy(node->WHILE.expr);
-	eval(while_expr);
-	while (while_expr->type == TYPE_VAR)
-	{
-		eval(while_expr->VAR.value);
-		while_expr = while_expr->VAR.value;
-	}
-	while (while_expr->BOOL.value == true)
+	while (eval_condition(node->WHILE().expr))
 	{
-		for (auto expr : node->WHILE.body)
+		for (auto& expr : node->WHILE().body)
 		{
-			auto expr_copy = deep_copy(expr);
-
-			eval(expr_copy);
+			auto result = eval(expr);
 
-			if (expr_copy->type == TYPE_BREAK)
+			if (result->type == TYPE_BREAK)
 			{
-				return;
+				return empty;
 			}
-			else if (expr_copy->type == TYPE_BREAK_ALL)
+			else if (result->type == TYPE_BREAK_ALL || result->type == TYPE_RETURN)
 			{
-				node->type = TYPE_BREAK_ALL;
-				return;
+				return result;
 			}
 		}
-
-		while_expr = deep_copy(node->WHILE.expr);
-		eval(while_expr);
-		while (while_expr->type == TYPE_VAR)
-		{
-			eval(while_expr->VAR.value);
-			while_expr = while_expr->VAR.value;
-		}
 	}
+
+	return empty;
 }
 
 // ########### TYPE ASSIGNMENT ########### //
 
 // ########### FUNC DEF ########### //
 
-void AST_Eval::eval_func_def(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_func_def(std::shared_ptr<AST_Node>& node)
 {
 	std::shared_ptr<AST_Node> func_var = std::make_shared<AST_Node>(TYPE_VAR);
 
-	func_var->VAR.name = node->FUNC_DEF.name;
-	func_var->VAR.value = std::make_shared<AST_Node>(*node);
+	func_var->VAR().symbol = intern(node->FUNC_DEF().name);
+	func_var->VAR().set(node);
 
-	current_scope->SCOPE.data.push_back(func_var);
-	node->type = TYPE_EMPTY;
-	return;
+	add_data_to_scope(func_var, current_scope);
+	return empty;
 }
 
-void AST_Eval::eval_return(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_return(std::shared_ptr<AST_Node>& node)
 {
-	eval(node->RETURN.value);
-	node = node->RETURN.value;
-	return;
+	auto value = eval(node->RETURN().value);
+
+	// The enclosing call takes the value out, after which the node is free for the next return
+	if (!return_node || return_node.use_count() > 1)
+	{
+		return_node = std::make_shared<AST_Node>(TYPE_RETURN);
+	}
+
+	return_node->RETURN().value = std::move(value);
+	return return_node;
 }
 
 // ########### CALL ########### //
 
-void AST_Eval::eval_call(std::shared_ptr<AST_Node>& node)
+std::shared_ptr<AST_Node> AST_Eval::eval_call(std::shared_ptr<AST_Node>& node)
 {
-	if (node->CALL.name == "print")
+	if (node->CALL().name == "print")
 	{
-		for (auto& arg : node->CALL.args)
+		for (auto& arg : node->CALL().args)
 		{
-			eval(arg);
-			print_ast_node(arg);
+			print_ast_node(eval(arg));
 		}
 
-		node->type = TYPE_EMPTY;
-		return;
+		return empty;
 	}
 
-	if (node->CALL.name == "type_of")
+	if (node->CALL().name == "type_of")
 	{
-		if (node->CALL.args.size() != 1)
+		if (node->CALL().args.size() != 1)
 		{
-			node->type = TYPE_ERROR;
 			std::cout << "\n" + log_error(node, "Built-in function 'type_of' only accepts one argument.");
-			return;
+			return create_error(node);
 		}
 
-		auto& arg = node->CALL.args[0];
-
-		eval(arg);
-
-		node = infer_type(arg);
+		auto arg = eval(node->CALL().args[0]);
 
-		return;
+		return infer_type(arg);
 	}
 
-	if (node->CALL.name == "str")
+	if (node->CALL().name == "str")
 	{
-		if (node->CALL.args.size() != 1)
+		if (node->CALL().args.size() != 1)
 		{
-			node->type = TYPE_ERROR;
 			std::cout << "\n" + log_error(node, "Built-in function 'str' only accepts one argument.");
-			return;
+			return create_error(node);
 		}
 
-		auto arg = deep_copy(node->CALL.args[0]);
+		auto arg = eval(node->CALL().args[0]);
 
-		call_str(arg);
-		node = arg;
-		return;
+		return call_str(arg);
 	}
 
-	if (node->CALL.name == "ref")
+	if (node->CALL().name == "ref")
 	{
-		if (node->CALL.args.size() != 1)
+		if (node->CALL().args.size() != 1)
 		{
-			node->type = TYPE_ERROR;
 			std::cout << "\n" + log_error(node, "Built-in function 'ref' only accepts one argument.");
-			return;
+			return create_error(node);
 		}
 
-		auto& arg = node->CALL.args[0];
-
-		eval(arg);
-
-		node->type = TYPE_REF;
-		node->REF.ref = arg;
-		return;
+		auto ref = std::make_shared<AST_Node>(TYPE_REF);
+		ref->REF().ref = eval(node->CALL().args[0]);
+		return ref;
 	}
 
-	if (node->CALL.name == "import")
+	if (node->CALL().name == "import")
 	{
-		if (node->CALL.args.size() != 1)
+		if (node->CALL().args.size() != 1)
 		{
-			node->type = TYPE_ERROR;
 			std::cout << "\n" + log_error(node, "Built-in function 'import' only accepts one argument.");
-			return;
+			return create_error(node);
 		}
 
-		auto& arg = node->CALL.args[0];
-
-		call_import(arg);
-		node = arg;
-		return;
+		return call_import(node->CALL().args[0]);
 	}
 
 	// Custom Functions
 
-	auto func_var = get_data(node->CALL.name);
-	auto func = std::make_shared<AST_Node>(*func_var->VAR.value);
-	auto func_scope = new_scope();
-	for (int i = 0; i < node->CALL.args.size(); i++)
+	auto func_var = get_data(node->CALL().name);
+	if (!func_var || func_var->VAR().value.type() != TYPE_FUNC_DEF)
 	{
-		eval(node->CALL.args[i]);
+		std::cout << "\n" << log_error(node, "Function '" + node->CALL().name + "' is not defined.");
+		return create_error(node);
 	}
-	if (func->FUNC_DEF.params.size() != node->CALL.args.size())
+
+	auto& func = func_var->VAR().node;
+	if (func->FUNC_DEF().params.size() != node->CALL().args.size())
 	{
-		std::cout << "\n" << log_error(node, "Function '" + node->CALL.name + "' expects " +
-			std::to_string(func->FUNC_DEF.params.size()) + " argument(s).");
-		node->type = TYPE_ERROR;
-		return;
+		std::cout << "\n" << log_error(node, "Function '" + node->CALL().name + "' expects " +
+			std::to_string(func->FUNC_DEF().params.size()) + " argument(s).");
+		return create_error(node);
 	}
-	enter_scope(func_scope);
-	for (int i = 0; i < node->CALL.args.size(); i++)
+
+	// Arguments are evaluated in the caller's scope, onto a stack shared by all calls
+	size_t base = call_args.size();
+	for (auto& arg : node->CALL().args)
+	{
+		call_args.push_back(eval(arg));
+	}
+
+	if (!materialize_body(func->FUNC_DEF()))
 	{
-		auto var_name = func->FUNC_DEF.params[i]->ID.value;
-		auto var_value = std::make_shared<AST_Node>(*node->CALL.args[i]);
-		auto var = create_var(var_name, var_value);
-		current_scope->SCOPE.data.push_back(var);
+		call_args.resize(base);
+		std::cout << "\n" << log_error(node, "Function '" + node->CALL().name + "' has syntax errors in its body.");
+		return create_error(node);
 	}
-	for (auto expr : func->FUNC_DEF.body)
+
+	push_frame(func->FUNC_DEF());
+	for (size_t i = 0; i < func->FUNC_DEF().params.size(); i++)
+	{
+		bind_param(func->FUNC_DEF(), i, call_args[base + i]);
+	}
+	call_args.resize(base);
+
+	std::shared_ptr<AST_Node> return_value = empty;
+	for (auto& expr : func->FUNC_DEF().body)
 	{
-		auto expr_copy = deep_copy(expr);
-		if (expr_copy->type == TYPE_RETURN)
+		auto result = eval(expr);
+		if (result->type == TYPE_RETURN)
 		{
-			eval_return(expr_copy);
-			node = expr_copy;
-			return;
+			return_value = std::move(result->RETURN().value);
+			break;
 		}
-		eval(expr_copy);
 	}
-	exit_scope();
-	delete_scope(func_scope);
+	pop_frame();
 
-	return;
+	return return_value;
 }
 
-void AST_Eval::call_str(std::shared_ptr<AST_Node>& arg)
+std::shared_ptr<AST_Node> AST_Eval::call_str(std::shared_ptr<AST_Node>& arg)
 {
-	eval(arg);
+	if (arg->type == TYPE_VAR)
+	{
+		return call_str(arg->VAR().get());
+	}
+
+	auto str = std::make_shared<AST_Node>(TYPE_STRING);
 
 	if (arg->type == TYPE_INT)
 	{
-		arg->STRING.value = std::to_string(arg->INT.value);
-		arg->type = TYPE_STRING;
+		str->STRING().value = std::to_string(arg->INT.value);
 	}
 	else if (arg->type == TYPE_FLOAT)
 	{
-		arg->STRING.value = std::to_string(arg->FLOAT.value);
-		arg->type = TYPE_STRING;
+		str->STRING().value = std::to_string(arg->FLOAT.value);
 	}
 	else if (arg->type == TYPE_BOOL)
 	{
-		arg->STRING.value = std::to_string(arg->BOOL.value);
-		arg->type = TYPE_STRING;
+		str->STRING().value = std::to_string(arg->BOOL.value);
 	}
-	else if (arg->type == TYPE_VAR)
+	else
 	{
-		call_str(arg->VAR.value);
-		arg = arg->VAR.value;
+		return arg;
 	}
 
-	return;
+	return str;
+}
+
+Module_Cache& module_cache()
+{
+	static Module_Cache cache;
+	return cache;
 }
 
-void AST_Eval::call_import(std::shared_ptr<AST_Node>& arg)
+std::shared_ptr<AST_Node> AST_Eval::call_import(std::shared_ptr<AST_Node>& arg)
 {
-	Lexer lexer(arg->STRING.value);
+	auto& cache = module_cache();
+
+	// Anything but a string imports '', which fails as an empty file
+	auto file = arg->find_payload<String_Node>();
+	std::string file_name = file ? file->value : "";
+
+	// Missing files skip the cache and fail below like before
+	std::error_code error;
+	auto path = std::filesystem::canonical(file_name, error);
+	auto mtime = std::filesystem::last_write_time(path, error);
+	auto size = std::filesystem::file_size(path, error);
+
+	if (!error)
+	{
+		auto module = cache.modules.find(path.string());
+		if (module != cache.modules.end() && module->second.mtime == mtime && module->second.size == size)
+		{
+			cache.hits++;
+			return module->second.scope;
+		}
+
+		cache.misses++;
+	}
+
+	Lexer lexer(file_name);
 
 	if (lexer.get_source().size() == 0)
 	{
-		arg->type = TYPE_ERROR;
 		std::cout << "\n" + log_error(arg, "Cannot import empty file.");
-		return;
+		return create_error(arg);
 	}
 
-	lexer.tokenize();
+	AST_Parser parser = parse_cached(lexer);
 
-	AST_Parser parser(lexer);
-	parser.parse();
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
 
 	AST_Eval eval;
+	eval.source = parser.source;
 
 	eval.init();
+	eval.global_scope->SCOPE().slots.resize(globals);
 
 	if (parser.expressions.size() == 0)
 	{
 		std::cin.get();
-		return;
+		return arg;
 	}
 
-	for (auto expr : parser.expressions)
+	for (auto& expr : parser.expressions)
 	{
 		eval.eval(expr);
 	}
 
-	*arg = *eval.global_scope;
-	return;
-}
\ No newline at end of file
+	if (!error)
+	{
+		cache.modules[path.string()] = { mtime, size, eval.global_scope };
+	}
+
+	return eval.global_scope;
+}
@@ -1,30 +1,92 @@
 #pragma once
+#include <filesystem>
 
 #include "AST_Parser.hpp"
+#include "AST_Cache.hpp"
+#include "AST_Resolver.hpp"
 #include "AST_Utils.hpp"
 #include "Type.hpp"
 
-std::string not_implemented_error(std::shared_ptr<AST_Node>& op);
+// Handlers for one binary operator, by the types of its operands
+struct Binary_Table;
+
+std::string not_implemented_error(Type op, std::shared_ptr<AST_Node> left, std::shared_ptr<AST_Node> right);
+
+// Evaluated modules, shared by every AST_Eval in the process. Entries are keyed by canonical
+// path and are only reused while the file's size and modification time are unchanged.
+struct Module_Cache
+{
+	struct Module
+	{
+		std::filesystem::file_time_type mtime;
+		std::uintmax_t size = 0;
+		std::shared_ptr<AST_Node> scope = nullptr;
+	};
+
+	std::unordered_map<std::string, Module> modules;
+	int hits = 0;
+	int misses = 0;
+};
+
+Module_Cache& module_cache();
+
+// Sites rewritten into a specialized form across the process, and how many of those have
+// since fallen back to the generic path
+struct Quickening_Stats
+{
+	int quickened = 0;
+	int deoptimized = 0;
+};
+
+Quickening_Stats& quickening_stats();
 
 class AST_Eval
 {
 public:
 
 	std::string file_name = "stdin";
+
+	// Source of the evaluated tree, for error positions
+	std::shared_ptr<Source_Buffer> source;
 	std::vector<std::string> errors;
 
 	int __scopes_num = 0;
 
 	AST_Eval() = default;
 
-	AST_Eval(AST_Parser parser) : file_name(parser.file_name) {}
+	AST_Eval(AST_Parser parser) : file_name(parser.file_name), source(parser.source) {}
 
 	std::shared_ptr<AST_Node> global_scope = std::make_shared<AST_Node>(TYPE_SCOPE);
 	std::shared_ptr<AST_Node>& current_scope = global_scope;
 
+	// Shared result for statements that produce no value. Results are never mutated,
+	// so the parsed tree can be evaluated any number of times without copying it.
+	std::shared_ptr<AST_Node> empty = std::make_shared<AST_Node>(TYPE_EMPTY);
+
+	// Scopes of user function calls, by call depth. A frame and its param vars are reused by
+	// the next call at the same depth unless something still holds them.
+	std::vector<std::shared_ptr<AST_Node>> frames;
+	size_t call_depth = 0;
+	size_t frames_allocated = 0;
+
+	// Numbers scope activations, see Scope_Node::activation
+	size_t activations = 0;
+
+	// Result of the last 'return', reused by the next one once its call has taken the value
+	std::shared_ptr<AST_Node> return_node = nullptr;
+
+	// Evaluated arguments of the calls being set up
+	std::vector<std::shared_ptr<AST_Node>> call_args;
+
+	// Rewrite binary operators and variable reads into specialized forms once their operand
+	// types are stable
+	bool quicken = true;
+	static const int QUICKEN_AFTER = 8;
+
 	std::string log_error(std::shared_ptr<AST_Node>& error_node, std::string message)
 	{
-		std::string error_message = "[Eval] Evaluation Error in '" + file_name + "' @ (" + std::to_string(error_node->line) + ", " + std::to_string(error_node->column) + "): " + message;
+		Source_Location location = source ? source->location(error_node->offset) : Source_Location();
+		std::string error_message = "[Eval] Evaluation Error in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 		errors.push_back(error_message);
 		return error_message;
 	}
@@ -33,40 +95,110 @@ public:
 
 	std::shared_ptr<AST_Node> infer_type(std::shared_ptr<AST_Node>& node);
 
-	int implicit_cast(std::shared_ptr<AST_Node>& value, std::string type);
+	// Registered id of the value's type, without allocating a type node
+	int infer_type_id(std::shared_ptr<AST_Node>& node);
+
+	// Replaces 'value' by a copy cast to type id 'type' where the cast table allows it.
+	// Returns a Cast_Result.
+	int implicit_cast(std::shared_ptr<AST_Node>& value, int type);
+
+	// 'type' is a type id; -1 infers it from 'value'
+	std::shared_ptr<AST_Node> create_var(std::string name, std::shared_ptr<AST_Node> value, int type = -1);
+
+	std::shared_ptr<AST_Node> get_data(const std::string& name);
+
+	std::shared_ptr<AST_Node> get_data(int symbol);
+
+	// Uses the resolved slot when the var already exists there, the symbol lookup otherwise
+	std::shared_ptr<AST_Node> get_data(ID_Node& id);
+
+	// The filled slot 'id' was resolved to, or nullptr
+	std::shared_ptr<AST_Node>* find_slot(ID_Node& id);
+
+	std::shared_ptr<AST_Node> get_data_from_scope(const std::string& name, std::shared_ptr<AST_Node> scope);
+
+	void add_data_to_scope(std::shared_ptr<AST_Node> var, std::shared_ptr<AST_Node> scope);
+
+	void add_data_to_scope(std::shared_ptr<AST_Node> var, std::shared_ptr<AST_Node> scope, ID_Node& id);
 
-	std::shared_ptr<AST_Node> create_var(std::string name, std::shared_ptr<AST_Node> value, 
-		std::shared_ptr<AST_Node> type = nullptr);
+	std::shared_ptr<AST_Node> create_error(std::shared_ptr<AST_Node>& node);
 
-	std::shared_ptr<AST_Node> get_data(std::string name);
+	bool is_control(std::shared_ptr<AST_Node>& result);
 
-	std::shared_ptr<AST_Node> get_data_from_scope(std::string name, std::shared_ptr<AST_Node> scope);
+	std::shared_ptr<AST_Node> eval(std::shared_ptr<AST_Node>& node);
 
-	void eval(std::shared_ptr<AST_Node>& node);
+	// ---- Quickening ---- //
 
-	void eval_plus(std::shared_ptr<AST_Node>& node);
+	// Records that 'node' could have run as 'form' this time, rewriting it after
+	// QUICKEN_AFTER evaluations in a row agree
+	void profile(AST_Node& node, Quick_Op form);
 
-	void eval_minus(std::shared_ptr<AST_Node>& node);
+	void deoptimize(AST_Node& node);
 
-	void eval_mul(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_quick(std::shared_ptr<AST_Node>& node);
 
-	void eval_div(std::shared_ptr<AST_Node>& node);
+	// Evaluates 'node' without boxing an int, float or bool result where it can: literals, slot
+	// reads and quickened operators. 'holder' keeps an object result alive.
+	Value eval_value(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& holder);
 
-	void eval_neg(std::shared_ptr<AST_Node>& node);
+	// A quickened operator's result
+	Value quick_value(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& holder);
 
-	void eval_pos(std::shared_ptr<AST_Node>& node);
+	bool eval_condition(std::shared_ptr<AST_Node>& node);
 
-	void eval_eq_check(std::shared_ptr<AST_Node>& node);
+	// The generic apply_* for 'node's operator
+	std::shared_ptr<AST_Node> apply_operator(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
 
-	void eval_not_eq_check(std::shared_ptr<AST_Node>& node);
+	// Applies the handler 'table' has for the operands' types, or reports the pair as unsupported
+	std::shared_ptr<AST_Node> apply_binary(const Binary_Table& table, std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
 
-	void eval_assignment(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_plus(std::shared_ptr<AST_Node>& node);
 
-	void eval_block(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> apply_plus(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
 
-	void eval_scope_accessor(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_minus(std::shared_ptr<AST_Node>& node);
 
-	std::shared_ptr<AST_Node> new_scope(std::string name = "");
+	std::shared_ptr<AST_Node> apply_minus(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_mul(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_mul(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_div(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_div(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_neg(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_neg(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_pos(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_pos(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_eq_check(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_eq_check(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_not_eq_check(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> apply_not_eq_check(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& left, std::shared_ptr<AST_Node>& right);
+
+	std::shared_ptr<AST_Node> eval_assignment(std::shared_ptr<AST_Node>& node);
+
+	// Assignment from a quickened expression: a scalar replacing one of the same type goes
+	// straight into the var
+	std::shared_ptr<AST_Node> assign_value(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> store(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node>& var, std::shared_ptr<AST_Node> right);
+
+	std::shared_ptr<AST_Node> eval_block(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> eval_scope_accessor(std::shared_ptr<AST_Node>& node);
+
+	std::shared_ptr<AST_Node> access_scope(std::shared_ptr<AST_Node>& node, std::shared_ptr<AST_Node> scope);
+
+	std::shared_ptr<AST_Node> new_scope(std::string name = "", int slots = 0);
 
 	void enter_scope(std::shared_ptr<AST_Node>& scope);
 
@@ -76,21 +208,37 @@ public:
 
 	void exit_scope();
 
-	void eval_id(std::shared_ptr<AST_Node>& node);
+	// ---- Call frames ---- //
+
+	// Enters a fresh scope for a call to 'func', taken from the frame stack. It has no entry in
+	// the caller's scope.
+	void push_frame(Func_Def_Node& func);
+
+	// The var for param 'index' in the frame just pushed, already in its slot
+	Var_Node& param_var(Func_Def_Node& func, int index);
+
+	// Stores argument 'index' in its param's var
+	void bind_param(Func_Def_Node& func, int index, Value value);
+
+	void bind_param(Func_Def_Node& func, int index, std::shared_ptr<AST_Node>& value);
+
+	void pop_frame();
+
+	std::shared_ptr<AST_Node> eval_id(std::shared_ptr<AST_Node>& node);
 
 	void eval_var(std::shared_ptr<AST_Node>& node);
 
-	void eval_if_else(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_if_else(std::shared_ptr<AST_Node>& node);
 
-	void eval_while(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_while(std::shared_ptr<AST_Node>& node);
 
-	void eval_func_def(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_func_def(std::shared_ptr<AST_Node>& node);
 
-	void eval_return(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_return(std::shared_ptr<AST_Node>& node);
 
-	void eval_call(std::shared_ptr<AST_Node>& node);
+	std::shared_ptr<AST_Node> eval_call(std::shared_ptr<AST_Node>& node);
 
-	void call_str(std::shared_ptr<AST_Node>& arg);
+	std::shared_ptr<AST_Node> call_str(std::shared_ptr<AST_Node>& arg);
 
-	void call_import(std::shared_ptr<AST_Node>& arg);
+	std::shared_ptr<AST_Node> call_import(std::shared_ptr<AST_Node>& arg);
 };
\ No newline at end of file
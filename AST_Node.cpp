@@ -1,107 +1,184 @@
 #include "AST_Node.hpp"
 
-std::shared_ptr<AST_Node> create_ref(std::shared_ptr<AST_Node> node)
+Payload payload_for(Type type)
 {
-	return node;
+	switch (type)
+	{
+	case TYPE_ID:					return ID_Node();
+	case TYPE_STRING:				return String_Node();
+	case TYPE_TYPE:					return Type_Node();
+	case TYPE_REF:					return Ref_Node();
+	case TYPE_VAR:					return Var_Node();
+	case TYPE_BLOCK:				return Block_Node();
+	case TYPE_CALL:					return Call_Node();
+	case TYPE_RETURN:				return Return_Node();
+	case TYPE_LIST:					return List_Node();
+	case TYPE_WHILE:				return While_Node();
+	case TYPE_IF:
+	case TYPE_ELSE:					return If_Node();
+	case TYPE_IF_ELSE_STATEMENT:	return If_Statement_Node();
+	case TYPE_SCOPE:				return Boxed<Scope_Node>();
+	case TYPE_FUNC_DEF:				return Boxed<Func_Def_Node>();
+	case TYPE_TYPE_DEF:				return Boxed<Type_Def_Node>();
+	default:						return std::monostate();
+	}
 }
 
-std::shared_ptr<AST_Node> create_copy(std::shared_ptr<AST_Node> node)
+std::shared_ptr<AST_Node> create_ref(std::shared_ptr<AST_Node> node)
 {
-	std::shared_ptr<AST_Node> r = std::make_shared<AST_Node>(*node);
-	return r;
+	return node;
 }
 
-std::shared_ptr<AST_Node> deep_copy(std::shared_ptr<AST_Node> node)
+Value to_value(AST_Node& node)
 {
-	if (node == nullptr)
-		return nullptr;
-
-	std::shared_ptr<AST_Node> node_copy = std::make_shared<AST_Node>(*node);
-
-	node_copy->left = deep_copy(node->left);
-	node_copy->right = deep_copy(node->right);
-
-	node_copy->INT.value = node->INT.value;
-	node_copy->FLOAT.value = node->FLOAT.value;
-	node_copy->BOOL.value = node->BOOL.value;
-	node_copy->STRING.value = node->STRING.value;
-	node_copy->ID.value = node->ID.value;
-
-	node_copy->CALL.name = node->CALL.name;
-	node_copy->CALL.args.clear();
-	for (auto arg : node->CALL.args)
+	switch (node.type)
 	{
-		node_copy->CALL.args.push_back(deep_copy(arg));
+	case TYPE_INT:
+		if (Value::fits_int(node.INT.value))
+		{
+			return Value::from_int(node.INT.value);
+		}
+		break;
+	case TYPE_FLOAT:
+		return Value::from_float(node.FLOAT.value);
+	case TYPE_BOOL:
+		return Value::from_bool(node.BOOL.value);
+	default:
+		break;
 	}
 
-	node_copy->FUNC_DEF.name = node->FUNC_DEF.name;
-	node_copy->FUNC_DEF.params.clear();
-	node_copy->FUNC_DEF.body.clear();
-	for (auto param : node->FUNC_DEF.params)
+	return Value::from_object(&node);
+}
+
+std::shared_ptr<AST_Node> to_node(Value value)
+{
+	auto node = std::make_shared<AST_Node>(value.type());
+
+	if (value.is_int())
 	{
-		node_copy->FUNC_DEF.params.push_back(deep_copy(param));
+		node->INT.value = value.as_int();
 	}
-	for (auto expr : node->FUNC_DEF.body)
+	else if (value.is_float())
 	{
-		node_copy->FUNC_DEF.body.push_back(deep_copy(expr));
+		node->FLOAT.value = value.as_float();
 	}
-
-	node_copy->BLOCK.name = node->BLOCK.name;
-	node_copy->BLOCK.body.clear();
-	for (auto expr : node->BLOCK.body)
+	else if (value.is_bool())
 	{
-		node_copy->BLOCK.body.push_back(deep_copy(expr));
+		node->BOOL.value = value.as_bool();
 	}
 
-	node_copy->IF.body = deep_copy(node->IF.body);
-	node_copy->IF.expr = deep_copy(node->IF.expr);
+	return node;
+}
 
-	node_copy->IF_STATEMENT.statements.clear();
-	for (auto stmnt : node->IF_STATEMENT.statements)
+void Var_Node::set(std::shared_ptr<AST_Node> value_node)
+{
+	if (value_node->type == TYPE_VAR)
 	{
-		node_copy->IF_STATEMENT.statements.push_back(deep_copy(stmnt));
+		auto& var = value_node->VAR();
+		value = var.value;
+		node = var.node;
+		return;
 	}
 
-	node_copy->REF.ref = deep_copy(node->REF.ref);
-
-	node_copy->TYPE.built_in = node->TYPE.built_in;
-	node_copy->TYPE.name = node->TYPE.name;
+	value = to_value(*value_node);
+	node = std::move(value_node);
+}
 
-	node_copy->VAR.name = node->VAR.name;
-	node_copy->VAR.type = deep_copy(node->VAR.type);
-	node_copy->VAR.value = deep_copy(node->VAR.value);
+std::shared_ptr<AST_Node> create_copy(std::shared_ptr<AST_Node> node)
+{
+	std::shared_ptr<AST_Node> r = std::make_shared<AST_Node>(*node);
+	return r;
+}
 
-	node_copy->TYPE_DEF.name = node->TYPE_DEF.name;
-	node_copy->TYPE_DEF.body.clear();
-	for (auto expr : node->TYPE_DEF.body)
+static void deep_copy_nodes(std::vector<std::shared_ptr<AST_Node>>& nodes)
+{
+	for (auto& node : nodes)
 	{
-		node_copy->TYPE_DEF.body.push_back(deep_copy(expr));
+		node = deep_copy(node);
 	}
+}
 
-	node_copy->RETURN.value = deep_copy(node->RETURN.value);
-
-	node_copy->LIST.items.clear();
-	for (auto item : node->LIST.items)
+// Replaces the children a copied payload still shares with the original by their own copies
+static void deep_copy_payload(Payload& payload)
+{
+	if (auto ref = std::get_if<Ref_Node>(&payload))
 	{
-		node_copy->LIST.items.push_back(deep_copy(item));
+		ref->ref = deep_copy(ref->ref);
 	}
-
-	node_copy->WHILE.expr = deep_copy(node->WHILE.expr);
-	node_copy->WHILE.body.clear();
-	for (auto expr : node->WHILE.body)
+	else if (auto var = std::get_if<Var_Node>(&payload))
 	{
-		node_copy->WHILE.body.push_back(deep_copy(expr));
+		if (var->node)
+		{
+			var->set(deep_copy(var->node));
+		}
 	}
-
-	node_copy->SCOPE.name = node->SCOPE.name;
-	node_copy->SCOPE.is_named = node->SCOPE.is_named;
-	node_copy->SCOPE.parent = node->SCOPE.parent;
-	node_copy->SCOPE.types = node->SCOPE.types;
-	node_copy->SCOPE.data.clear();
-	for (auto item : node->SCOPE.data)
+	else if (auto block = std::get_if<Block_Node>(&payload))
+	{
+		deep_copy_nodes(block->body);
+	}
+	else if (auto call = std::get_if<Call_Node>(&payload))
+	{
+		deep_copy_nodes(call->args);
+	}
+	else if (auto ret = std::get_if<Return_Node>(&payload))
 	{
-		node_copy->SCOPE.data.push_back(deep_copy(item));
+		ret->value = deep_copy(ret->value);
 	}
+	else if (auto list = std::get_if<List_Node>(&payload))
+	{
+		deep_copy_nodes(list->items);
+	}
+	else if (auto while_loop = std::get_if<While_Node>(&payload))
+	{
+		while_loop->expr = deep_copy(while_loop->expr);
+		deep_copy_nodes(while_loop->body);
+	}
+	else if (auto if_node = std::get_if<If_Node>(&payload))
+	{
+		if_node->expr = deep_copy(if_node->expr);
+		if_node->body = deep_copy(if_node->body);
+	}
+	else if (auto if_statement = std::get_if<If_Statement_Node>(&payload))
+	{
+		deep_copy_nodes(if_statement->statements);
+	}
+	else if (auto func_def = std::get_if<Boxed<Func_Def_Node>>(&payload))
+	{
+		deep_copy_nodes(func_def->ptr->params);
+		deep_copy_nodes(func_def->ptr->body);
+		func_def->ptr->return_type = deep_copy(func_def->ptr->return_type);
+	}
+	else if (auto type_def = std::get_if<Boxed<Type_Def_Node>>(&payload))
+	{
+		deep_copy_nodes(type_def->ptr->body);
+	}
+	else if (auto scope = std::get_if<Boxed<Scope_Node>>(&payload))
+	{
+		auto& scope_node = *scope->ptr;
+		deep_copy_nodes(scope_node.data);
+		for (auto& slot : scope_node.slots)
+		{
+			slot = nullptr;
+		}
+		scope_node.index.clear();
+		for (auto& item : scope_node.data)
+		{
+			scope_node.index.emplace(item->VAR().symbol, item);
+		}
+	}
+}
+
+std::shared_ptr<AST_Node> deep_copy(std::shared_ptr<AST_Node> node)
+{
+	if (node == nullptr)
+		return nullptr;
+
+	std::shared_ptr<AST_Node> node_copy = std::make_shared<AST_Node>(*node);
+
+	node_copy->left = deep_copy(node->left);
+	node_copy->right = deep_copy(node->right);
+
+	deep_copy_payload(node_copy->payload);
 
 	return node_copy;
 }
\ No newline at end of file
@@ -1,23 +1,29 @@
 #pragma once
 #include <string>
 #include <map>
+#include <variant>
+#include <cassert>
 #include "Type.hpp"
+#include "Symbol.hpp"
+#include "Arena.hpp"
 #include "Token.hpp"
+#include "Value.hpp"
+#include "Type_Registry.hpp"
 
 struct AST_Node;
 
 struct Int_Node
 {
-	int value = 0;
+	int64_t value = 0;
 	Int_Node() = default;
-	Int_Node(int value) : value(value) {}
+	Int_Node(int64_t value) : value(value) {}
 };
 
 struct Float_Node
 {
-	float value = 0;
+	double value = 0;
 	Float_Node() = default;
-	Float_Node(float value) : value(value) {}
+	Float_Node(double value) : value(value) {}
 };
 
 struct Bool_Node
@@ -30,8 +36,14 @@ struct Bool_Node
 struct ID_Node
 {
 	std::string value = "";
+	int symbol = -1;
+
+	// Set by AST_Resolver: the var lives 'depth' scopes up, in 'slot'. -1 means dynamic lookup only.
+	int depth = -1;
+	int slot = -1;
+
 	ID_Node() = default;
-	ID_Node(std::string value) : value(value) {}
+	ID_Node(std::string value) : value(value), symbol(intern(value)) {}
 };
 
 struct String_Node
@@ -47,18 +59,43 @@ struct Call_Node
 	std::vector<std::shared_ptr<AST_Node>> args;
 };
 
+// A function body the parser skipped, kept as its source range from '{' to just past '}'.
+// Copies of the function share it, so the body is parsed at most once.
+struct Lazy_Body
+{
+	std::shared_ptr<Source_Buffer> source = nullptr;
+	std::string file_name = "";
+	uint32_t begin = 0;
+	uint32_t end = 0;
+
+	// Set by AST_Resolver when it reaches the function, so the body is resolved once parsed
+	bool resolve = false;
+
+	bool materialized = false;
+	std::vector<std::shared_ptr<AST_Node>> body;
+
+	// Set when the body has syntax errors; calls then fail without running anything
+	bool failed = false;
+	int slots = 0;
+};
+
 struct Func_Def_Node
 {
 	std::string name = "";
 	std::vector<std::shared_ptr<AST_Node>> params;
 	std::vector<std::shared_ptr<AST_Node>> body;
 	std::shared_ptr<AST_Node> return_type = nullptr;
+	int slots = 0;
+
+	// Set while 'body' hasn't been parsed yet; see materialize_body()
+	std::shared_ptr<Lazy_Body> lazy = nullptr;
 };
 
 struct Block_Node
 {
 	std::string name = "";
 	std::vector<std::shared_ptr<AST_Node>> body;
+	int slots = 0;
 };
 
 struct If_Node
@@ -79,20 +116,37 @@ struct Ref_Node
 
 struct Type_Node
 {
-	std::string name = "";
+	// Registered id; see type_name() for the name
+	int id = TID_NONE;
 	bool built_in = true;
 };
 
 struct Var_Node
 {
-	std::string name = "";
-	std::shared_ptr<AST_Node> type = nullptr;
-	std::shared_ptr<AST_Node> value = nullptr;
+	// Interned name, -1 for vars that can't be looked up by name
+	int symbol = -1;
+
+	// Registered id of the type of 'value'
+	int type = TID_NONE;
+
+	// Ints, floats and bools are held unboxed in 'value', and 'node' is just their boxed form
+	// once something has asked for it. Any other value is an object that 'node' owns.
+	Value value;
+	std::shared_ptr<AST_Node> node = nullptr;
+
+	// The value as a node, boxing a scalar on first use
+	std::shared_ptr<AST_Node>& get();
+
+	// Takes the value out of another var rather than holding the var itself
+	void set(std::shared_ptr<AST_Node> value_node);
+
+	void set(Value scalar);
 };
 
 struct Type_Def_Node
 {
 	std::string name = "";
+	int id = TID_NONE;
 	std::vector<std::shared_ptr<AST_Node>> body;
 };
 
@@ -119,13 +173,70 @@ struct Scope_Node
 	bool is_named = false;
 
 	std::vector<std::shared_ptr<AST_Node>> data;
-	std::vector<std::string> types;
+
+	// Interned var name -> first var with that name in 'data'
+	std::unordered_map<int, std::shared_ptr<AST_Node>> index;
+
+	// Vars at the slots AST_Resolver assigned, null until they're created
+	std::vector<std::shared_ptr<AST_Node>> slots;
+
+	// A call frame's parameter vars, in order. They sit in their slots instead of 'data' and
+	// 'index', and name lookups check them first.
+	std::vector<std::shared_ptr<AST_Node>> params;
+
+	// Changes every time the scope is entered, so a reused frame counts as a new scope
+	size_t activation = 0;
 };
 
+// Heap box with value semantics, for payloads too large to keep inline in every node
+template <typename T>
+struct Boxed
+{
+	std::unique_ptr<T> ptr = std::make_unique<T>();
+
+	Boxed() = default;
+	Boxed(const Boxed& other) : ptr(std::make_unique<T>(*other.ptr)) {}
+	Boxed(Boxed&& other) = default;
+	Boxed& operator=(const Boxed& other) { ptr = std::make_unique<T>(*other.ptr); return *this; }
+	Boxed& operator=(Boxed&& other) = default;
+};
+
+template <typename T> struct Stored { using type = T; };
+template <> struct Stored<Scope_Node> { using type = Boxed<Scope_Node>; };
+template <> struct Stored<Func_Def_Node> { using type = Boxed<Func_Def_Node>; };
+template <> struct Stored<Type_Def_Node> { using type = Boxed<Type_Def_Node>; };
+
+template <typename T> T& unbox_payload(T& payload) { return payload; }
+template <typename T> T& unbox_payload(Boxed<T>& payload) { return *payload.ptr; }
+
+// Specialized forms AST_Eval rewrites a node into once it has seen the same operand types
+// at that site several times in a row. Each has a guard; a node whose guard fails goes back
+// to the generic path for good.
+enum Quick_Op : uint8_t
+{
+	QUICK_NONE,				// still being profiled
+	QUICK_GENERIC,			// unstable or deoptimized
+	QUICK_SLOT,				// variable read straight from its resolved slot
+	QUICK_ADD_INT_INT,		QUICK_ADD_FLOAT_FLOAT,
+	QUICK_SUB_INT_INT,		QUICK_SUB_FLOAT_FLOAT,
+	QUICK_MUL_INT_INT,		QUICK_MUL_FLOAT_FLOAT,
+	QUICK_DIV_INT_INT,		QUICK_DIV_FLOAT_FLOAT,
+	QUICK_EQ_INT_INT,		QUICK_EQ_FLOAT_FLOAT,
+	QUICK_NOT_EQ_INT_INT,	QUICK_NOT_EQ_FLOAT_FLOAT,
+	QUICK_COUNT
+};
+
+using Payload = std::variant<std::monostate, ID_Node, String_Node, Type_Node, Ref_Node, Var_Node, Block_Node,
+	Call_Node, Return_Node, List_Node, While_Node, If_Node, If_Statement_Node,
+	Boxed<Scope_Node>, Boxed<Func_Def_Node>, Boxed<Type_Def_Node>>;
+
+// The default payload of a node of 'type'; monostate for types without one
+Payload payload_for(Type type);
+
 struct AST_Node
 {
-	int column = 1;
-	int line = 1;
+	// Byte offset of the node's first token in its source
+	uint32_t offset = 0;
 
 	Type type = TYPE_EMPTY;
 	std::shared_ptr<AST_Node> left = nullptr;
@@ -137,37 +248,137 @@ struct AST_Node
 	bool is_p_expr = false;
 	bool is_list_item = false;
 
+	// Type feedback: the form this node has been rewritten into, and the form its last
+	// 'quick_hits' evaluations could have used
+	Quick_Op quick = QUICK_NONE;
+	Quick_Op quick_candidate = QUICK_NONE;
+	uint8_t quick_hits = 0;
+
 	AST_Node() = default;
 
-	AST_Node(Type type) : type(type) {}
+	AST_Node(Type type) : type(type), payload(payload_for(type)) {}
 
-	AST_Node(std::shared_ptr<Token> token) 
-		: type(token->type), column(token->column), line(token->line), is_op(token->is_op), is_post_op(token->is_post_op),	INT(token->int_value), FLOAT(token->float_value), BOOL(token->bool_value), ID(token->get_id_value()), 
-			STRING(token->get_string_value())
-		{}
+	AST_Node(const Token& token, std::string_view text = {})
+		: offset(token.offset), type(token.type), is_op(token.is_op()), is_post_op(token.is_post_op()),
+		INT(token.get_int_value()), FLOAT(token.get_float_value()), BOOL(token.get_bool_value())
+	{
+		if (token.type == TYPE_ID)
+		{
+			payload.emplace<ID_Node>(std::string(text));
+		}
+		else if (token.type == TYPE_STRING)
+		{
+			payload.emplace<String_Node>(std::string(text));
+		}
+	}
 
+	// Scalars stay inline: they're small, and truthiness reads BOOL of any node
 	Int_Node			INT;
 	Float_Node			FLOAT;
 	Bool_Node			BOOL;
-	ID_Node				ID;
-	String_Node			STRING;
-	Type_Node			TYPE;
-	Ref_Node			REF;
-	Var_Node			VAR;
-	Block_Node			BLOCK;
-	Scope_Node			SCOPE;
-	Func_Def_Node		FUNC_DEF;
-	Type_Def_Node		TYPE_DEF;
-	Call_Node			CALL;
-	Return_Node			RETURN;
-	List_Node			LIST;
-	While_Node			WHILE;
-	If_Node				IF;
-	If_Statement_Node	IF_STATEMENT;
+
+	// Everything else lives in the one payload that belongs to the node's type. It is created
+	// with the node, or by retype() when a node becomes another kind; reading never creates it.
+	Payload payload;
+
+	// Turns the node into a 'type' node with a fresh payload for that type
+	void retype(Type new_type)
+	{
+		type = new_type;
+		payload = payload_for(new_type);
+	}
+
+	// Returns nullptr if the node doesn't hold a T
+	template <typename T>
+	T* find_payload()
+	{
+		using S = typename Stored<T>::type;
+
+		if (auto value = std::get_if<S>(&payload))
+		{
+			return &unbox_payload(*value);
+		}
+
+		return nullptr;
+	}
+
+	template <typename T>
+	T& get_payload()
+	{
+		using S = typename Stored<T>::type;
+
+		assert(std::holds_alternative<S>(payload) && "node doesn't hold this payload");
+		return unbox_payload(std::get<S>(payload));
+	}
+
+	ID_Node&			ID()			{ return get_payload<ID_Node>(); }
+	String_Node&		STRING()		{ return get_payload<String_Node>(); }
+	Type_Node&			TYPE()			{ return get_payload<Type_Node>(); }
+	Ref_Node&			REF()			{ return get_payload<Ref_Node>(); }
+	Var_Node&			VAR()			{ return get_payload<Var_Node>(); }
+	Block_Node&			BLOCK()			{ return get_payload<Block_Node>(); }
+	Scope_Node&			SCOPE()			{ return get_payload<Scope_Node>(); }
+	Func_Def_Node&		FUNC_DEF()		{ return get_payload<Func_Def_Node>(); }
+	Type_Def_Node&		TYPE_DEF()		{ return get_payload<Type_Def_Node>(); }
+	Call_Node&			CALL()			{ return get_payload<Call_Node>(); }
+	Return_Node&		RETURN()		{ return get_payload<Return_Node>(); }
+	List_Node&			LIST()			{ return get_payload<List_Node>(); }
+	While_Node&			WHILE()			{ return get_payload<While_Node>(); }
+	If_Node&			IF()			{ return get_payload<If_Node>(); }
+	If_Statement_Node&	IF_STATEMENT()	{ return get_payload<If_Statement_Node>(); }
 };
 
+// Allocates the node and its control block in 'arena'
+template <typename... Args>
+std::shared_ptr<AST_Node> make_node(std::shared_ptr<Arena>& arena, Args&&... args)
+{
+	return std::allocate_shared<AST_Node>(Arena_Allocator<AST_Node>(arena), std::forward<Args>(args)...);
+}
+
 std::shared_ptr<AST_Node> create_ref(std::shared_ptr<AST_Node> node);
 
 std::shared_ptr<AST_Node> create_copy(std::shared_ptr<AST_Node> node);
 
-std::shared_ptr<AST_Node> deep_copy(std::shared_ptr<AST_Node> node);
\ No newline at end of file
+std::shared_ptr<AST_Node> deep_copy(std::shared_ptr<AST_Node> node);
+
+// The int, float or bool 'node' holds, or 'node' itself as an object
+Value to_value(AST_Node& node);
+
+// A new node holding the int, float or bool in 'value'; objects are never boxed again
+std::shared_ptr<AST_Node> to_node(Value value);
+
+inline Type Value::type() const
+{
+	if (is_float())
+	{
+		return TYPE_FLOAT;
+	}
+
+	switch (bits & TAG)
+	{
+	case INT:
+		return TYPE_INT;
+	case BOOL:
+		return TYPE_BOOL;
+	case EMPTY:
+		return TYPE_EMPTY;
+	default:
+		return as_object()->type;
+	}
+}
+
+inline std::shared_ptr<AST_Node>& Var_Node::get()
+{
+	if (!node)
+	{
+		node = to_node(value);
+	}
+
+	return node;
+}
+
+inline void Var_Node::set(Value scalar)
+{
+	value = scalar;
+	node = nullptr;
+}
@@ -1,13 +1,31 @@
 #include "AST_Parser.hpp"
+#include "AST_Resolver.hpp"
 
-AST_Parser::AST_Parser(std::vector<std::shared_ptr<Token>>& tokens, std::string file_name) : tokens(tokens), file_name(file_name)
+AST_Parser::AST_Parser(Lexer& lexer) : file_name(lexer.get_file_name()), lexer(&lexer), source(lexer.get_buffer())
 {
-	token = tokens[0];
+	if (lexer.tokens.size() == 0)
+	{
+		lexer.tokens.set_window(TOKEN_WINDOW);
+	}
+
+	token = token_at(0);
 }
 
-AST_Parser::AST_Parser(Lexer lexer) : tokens(lexer.tokens), file_name(lexer.get_file_name())
+Token* AST_Parser::token_at(int position)
 {
-	token = tokens[0];
+	Token_Stream& tokens = lexer->tokens;
+
+	while ((size_t)position >= tokens.size() && !lexer->finished)
+	{
+		lexer->next_token();
+	}
+
+	if ((size_t)position >= tokens.size())
+	{
+		return &tokens[tokens.size() - 1];
+	}
+
+	return &tokens[position];
 }
 
 void AST_Parser::advance()
@@ -17,7 +35,7 @@ void AST_Parser::advance()
 		return;
 	}
 
-	token = tokens[++index];
+	token = token_at(++index);
 }
 
 void AST_Parser::backtack()
@@ -27,29 +45,25 @@ void AST_Parser::backtack()
 		return;
 	}
 
-	token = tokens[--index];
+	token = token_at(--index);
 }
 
-std::shared_ptr<Token> AST_Parser::peek(int n)
+Token* AST_Parser::peek(int n)
 {
-	if ((index + n) > tokens.size() - 1)
-	{
-		return tokens[tokens.size() - 1];
-	}
-
 	if ((index + n) < 0)
 	{
-		return tokens[0];
+		return token_at(0);
 	}
 
-	return tokens[index + n];
+	return token_at(index + n);
 }
 
 // ---- Error Handling ---- //
 
 void AST_Parser::error_and_skip_to(Type type, std::shared_ptr<AST_Node> error_node, std::string message)
 {
-	std::string error_message = "[Parser] Syntax Error in '" + file_name + "' @ (" + std::to_string(error_node->line) + ", " + std::to_string(error_node->column) + "): " + message;
+	Source_Location location = source->location(error_node->offset);
+	std::string error_message = "[Parser] Syntax Error in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	errors.push_back(error_message);
 
 	while (token->type != type && token->type != TYPE_EOF)
@@ -58,9 +72,10 @@ void AST_Parser::error_and_skip_to(Type type, std::shared_ptr<AST_Node> error_no
 	}
 }
 
-void AST_Parser::error_and_skip_to(Type type, std::shared_ptr<Token> error_token, std::string message)
+void AST_Parser::error_and_skip_to(Type type, Token* error_token, std::string message)
 {
-	std::string error_message = "[Parser] Syntax Error in '" + file_name + "' @ (" + std::to_string(error_token->line) + ", " + std::to_string(error_token->column) + "): " + message;
+	Source_Location location = source->location(error_token->offset);
+	std::string error_message = "[Parser] Syntax Error in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	errors.push_back(error_message);
 
 	while (token->type != type && token->type != TYPE_EOF)
@@ -71,7 +86,8 @@ void AST_Parser::error_and_skip_to(Type type, std::shared_ptr<Token> error_token
 
 void AST_Parser::warn_and_skip_to(Type type, std::shared_ptr<AST_Node> warning_node, std::string message)
 {
-	std::string warning_message = "[Parser] Warning in '" + file_name + "' @ (" + std::to_string(warning_node->line) + ", " + std::to_string(warning_node->column) + "): " + message;
+	Source_Location location = source->location(warning_node->offset);
+	std::string warning_message = "[Parser] Warning in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	warnings.push_back(warning_message);
 
 	while (token->type != type && token->type != TYPE_EOF)
@@ -80,9 +96,10 @@ void AST_Parser::warn_and_skip_to(Type type, std::shared_ptr<AST_Node> warning_n
 	}
 }
 
-void AST_Parser::warn_and_skip_to(Type type, std::shared_ptr<Token> warning_token, std::string message)
+void AST_Parser::warn_and_skip_to(Type type, Token* warning_token, std::string message)
 {
-	std::string warning_message = "[Parser] Warning in '" + file_name + "' @ (" + std::to_string(warning_token->line) + ", " + std::to_string(warning_token->column) + "): " + message;
+	Source_Location location = source->location(warning_token->offset);
+	std::string warning_message = "[Parser] Warning in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	warnings.push_back(warning_message);
 
 	while (token->type != type && token->type != TYPE_EOF)
@@ -130,101 +147,143 @@ void AST_Parser::check_for_errors()
 
 // ---- Parsing ---- //
 
-std::shared_ptr<AST_Node> AST_Parser::parse_expression(std::vector<std::shared_ptr<AST_Node>> raw_expression)
+// How loosely each node type binds; a node takes over subtrees that bind at least as tightly.
+// Types not listed bind at 0.
+struct Binding_Power
 {
-	#define ADVANCE() node = raw_expression[++index]
+	Type type;
+	int power;
+};
 
-	std::shared_ptr<AST_Node> node = raw_expression[0];
-	int index = 0;
+constexpr Binding_Power BINDING_POWERS[] =
+{
+	{ TYPE_EQUAL,				300 },		{ TYPE_EQ_AND,				300 },
+	{ TYPE_AND,					200 },		{ TYPE_OR,					200 },
+	{ TYPE_RIGHT_ARROW,			180 },		{ TYPE_RIGHT_ARROW_SINGLE,	180 },
+	{ TYPE_COMMA,				170 },
+	{ TYPE_PLUS_EQ,				150 },		{ TYPE_MINUS_EQ,			150 },
+	{ TYPE_EQ_EQ,				100 },		{ TYPE_NOT_EQUAL,			100 },
+	{ TYPE_LT_EQUAL,			100 },		{ TYPE_GT_EQUAL,			100 },
+	{ TYPE_LANGLE,				100 },		{ TYPE_RANGLE,				100 },
+	{ TYPE_PLUS,				 40 },		{ TYPE_MINUS,				 40 },
+	{ TYPE_STAR,				 30 },		{ TYPE_SLASH,				 30 },
+	{ TYPE_POS,					 20 },		{ TYPE_NEG,					 20 },
+	{ TYPE_PLUS_PLUS,			  5 },		{ TYPE_MINUS_MINUS,			  5 },
+	{ TYPE_DOT,					  2 },		{ TYPE_DOUBLE_COLON,		  2 },		{ TYPE_COLON,		2 },
+	{ TYPE_CALL,				  1 },		{ TYPE_ID,					  1 },		{ TYPE_INT,			1 },
+	{ TYPE_FLOAT,				  1 },		{ TYPE_STRING,				  1 },		{ TYPE_TYPE,		1 },
+	{ TYPE_RANGE,				  1 },		{ TYPE_LIST,				  1 },		{ TYPE_BOOL,		1 },
+};
+
+struct Binding_Table
+{
+	int powers[TYPE_COUNT] = {};
+};
 
-	std::shared_ptr<AST_Node> root = std::make_shared<AST_Node>(TYPE_EMPTY);
+constexpr Binding_Table build_binding_table()
+{
+	Binding_Table table;
 
-	while (node->type != TYPE_END_OF_EXPRESSON)
+	for (const Binding_Power& entry : BINDING_POWERS)
 	{
-		if (node->type == TYPE_ERROR)
-		{
-			return node;
-		}
-
-		insert_in_ast(root, node);
-
-		ADVANCE();
+		table.powers[entry.type] = entry.power;
 	}
 
-	return root;
+	return table;
 }
 
-void AST_Parser::insert_in_ast(std::shared_ptr<AST_Node>& root, std::shared_ptr<AST_Node>& node)
+static constexpr Binding_Table binding_table = build_binding_table();
+
+void Expression::add(std::shared_ptr<AST_Node> node)
 {
-	if (root == nullptr)
+	if (error)
 	{
-		root = std::make_shared<AST_Node>(TYPE_EMPTY);
+		return;
 	}
 
-	else if (root->type == TYPE_EMPTY)
+	if (node->type == TYPE_ERROR)
 	{
-		root = node;
+		error = node;
+		return;
 	}
-	else if (root->is_p_expr)
-	{
-		if (node->is_post_op)
-			node->right = root;
-		else
-			node->left = root;
 
+	if (!root)
+	{
 		root = node;
+		return;
 	}
-	else if (node->is_p_expr)
+
+	std::shared_ptr<AST_Node>* link = &root;
+
+	while (true)
 	{
-		if (root->right)
+		AST_Node* current = link->get();
+
+		if (current->type == TYPE_EMPTY)
 		{
-			insert_in_ast(root->right, node);
+			*link = node;
+			return;
 		}
-		else
+
+		if (current->is_p_expr ||
+			(!node->is_p_expr && binding_table.powers[node->type] >= binding_table.powers[current->type]))
+		{
+			if (node->is_post_op)
+			{
+				node->right = *link;
+			}
+			else
+			{
+				node->left = *link;
+			}
+
+			*link = node;
+			return;
+		}
+
+		if (!current->right)
 		{
-			root->right = node;
+			current->right = node;
+			return;
 		}
+
+		link = &current->right;
 	}
-	else if (precedence[node->type] >= precedence[root->type])
-	{
-		if (node->is_post_op)
-			node->right = root;
-		else
-			node->left = root;
+}
 
-		root = node;
+std::shared_ptr<AST_Node> Expression::finish()
+{
+	if (error)
+	{
+		return error;
 	}
-	else
+
+	if (!root)
 	{
-		if (root->right)
-		{
-			insert_in_ast(root->right, node);
-		}
-		else
-		{
-			root->right = node;
-		}
+		// Kept off the arena; empty statements are dropped right away
+		return std::make_shared<AST_Node>(TYPE_EMPTY);
 	}
+
+	return root;
 }
 
-std::vector<std::shared_ptr<AST_Node>> AST_Parser::build_expression()
+std::shared_ptr<AST_Node> AST_Parser::parse_expression()
 {
-	std::vector<std::shared_ptr<AST_Node>> expr;
+	Expression expr;
 
 	while (token->type != TYPE_SEMICOLON)
 	{
 		if (token->type == TYPE_EOF)
 		{
-			std::shared_ptr<AST_Node> error = std::make_shared<AST_Node>(token);
+			std::shared_ptr<AST_Node> error = make_node(arena, *token, lexer->tokens.text(*token));
 			error->type = TYPE_ERROR;
-			expr.push_back(error);
+			expr.add(error);
 
 			error_and_skip_to(TYPE_EOF, error, "Missing ';' - Reached EOF.");
-			return expr;
+			return expr.finish();
 		}
 
-		std::shared_ptr<AST_Node> atom = parse_atom();
-		expr.push_back(atom);
+		expr.add(parse_atom());
 
 		// if something errors and skips to semicolon
 
@@ -233,60 +292,53 @@ std::vector<std::shared_ptr<AST_Node>> AST_Parser::build_expression()
 			break;
 		}
 
+		// A block ending the statement
 		if (token->type == TYPE_END_OF_EXPRESSON)
 		{
-			std::shared_ptr<AST_Node> end_of_expression = std::make_shared<AST_Node>(token);
-			end_of_expression->type = TYPE_END_OF_EXPRESSON;
-			expr.push_back(end_of_expression);
-
-			return expr;
+			return expr.finish();
 		}
 
 		advance();
 	}
 
-	std::shared_ptr<AST_Node> end_of_expression = std::make_shared<AST_Node>(token);
-	end_of_expression->type = TYPE_END_OF_EXPRESSON;
-	expr.push_back(end_of_expression);
-
-	return expr;
+	return expr.finish();
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_atom()
 {
-	if (token->type == TYPE_ID && token->get_id_value() == "if")
+	if (token->type == TYPE_KW_IF)
 	{
 		std::shared_ptr<AST_Node> node = parse_if_else_statement();
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "while")
+	else if (token->type == TYPE_KW_WHILE)
 	{
 		std::shared_ptr<AST_Node> node = parse_while_loop();
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "type")
+	else if (token->type == TYPE_KW_TYPE)
 	{
 		std::shared_ptr<AST_Node> node = parse_type_def();
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "def")
+	else if (token->type == TYPE_KW_DEF)
 	{
 		std::shared_ptr<AST_Node> node = parse_func_def();
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "return")
+	else if (token->type == TYPE_KW_RETURN)
 	{
 		std::shared_ptr<AST_Node> node = parse_return();
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "break")
+	else if (token->type == TYPE_KW_BREAK)
 	{
-		std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(TYPE_BREAK);
+		std::shared_ptr<AST_Node> node = make_node(arena, TYPE_BREAK);
 		return node;
 	}
-	else if (token->type == TYPE_ID && token->get_id_value() == "break_all")
+	else if (token->type == TYPE_KW_BREAK_ALL)
 	{
-		std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(TYPE_BREAK_ALL);
+		std::shared_ptr<AST_Node> node = make_node(arena, TYPE_BREAK_ALL);
 		return node;
 	}
 	else if (token->type == TYPE_ID && peek()->type == TYPE_LBRACE)
@@ -305,7 +357,7 @@ std::shared_ptr<AST_Node> AST_Parser::parse_atom()
 		return node;
 	}
 	else if ((token->type == TYPE_MINUS || token->type == TYPE_PLUS) &&
-		(peek(-1)->is_op || peek(-1)->type == TYPE_SEMICOLON || peek(-1)->type == TYPE_LPAREN ||
+		(peek(-1)->is_op() || peek(-1)->type == TYPE_SEMICOLON || peek(-1)->type == TYPE_LPAREN ||
 			peek(-1)->type == TYPE_LBRACKET || peek(-1)->type == TYPE_LBRACE ||
 			peek(-1)->type == TYPE_END_OF_EXPRESSON || peek(-1)->type == TYPE_COMMA ||
 			index == 0))
@@ -325,40 +377,34 @@ std::shared_ptr<AST_Node> AST_Parser::parse_atom()
 	}
 	else
 	{
-		std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
+		std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
 		return node;
 	}
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_list_item()
 {
-	std::shared_ptr<AST_Node> item = std::make_shared<AST_Node>(token);
-
-	std::vector<std::shared_ptr<AST_Node>> raw_expr;
+	Expression item;
 
 	while (token->type != TYPE_COMMA && token->type != TYPE_RBRACKET)
 	{
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing ']' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
-		std::shared_ptr<AST_Node> atom = parse_atom();
-		raw_expr.push_back(atom);
+		item.add(parse_atom());
 		advance();
 	}
 
-	raw_expr.push_back(std::make_shared<AST_Node>(TYPE_END_OF_EXPRESSON));
-
-	item = parse_expression(raw_expr);
-	return item;
+	return item.finish();
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_list()
 {
-	std::shared_ptr<AST_Node> list = std::make_shared<AST_Node>(token);
-	list->type = TYPE_LIST;
+	std::shared_ptr<AST_Node> list = make_node(arena, *token, lexer->tokens.text(*token));
+	list->retype(TYPE_LIST);
 
 	advance();
 
@@ -367,13 +413,13 @@ std::shared_ptr<AST_Node> AST_Parser::parse_list()
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, list, "Missing ']' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		auto item = parse_list_item();
 		item->is_list_item = true;
 
-		list->LIST.items.push_back(item);
+		list->LIST().items.push_back(item);
 
 		if (token->type == TYPE_RBRACKET)
 		{
@@ -394,47 +440,45 @@ std::shared_ptr<AST_Node> AST_Parser::parse_list()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_return()
 {
-	std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
-	node->type = TYPE_RETURN;
+	std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
+	node->retype(TYPE_RETURN);
 	advance();
-	auto raw_expr = build_expression();
-	std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
-	node->RETURN.value = expr;
+	node->RETURN().value = parse_expression();
 
 	return node;
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_func_def()
 {
-	std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
-	node->type = TYPE_FUNC_DEF;
+	std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
+	node->retype(TYPE_FUNC_DEF);
 
 	advance();
 	if (token->type != TYPE_ID)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, node, "Expected identifier.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
-	node->FUNC_DEF.name = *token->id_value;
+	node->FUNC_DEF().name = std::string(lexer->tokens.get_id_value(*token));
 
 	advance();
 	if (token->type != TYPE_LPAREN)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, node, "Expected '('.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	advance();
 	while (token->type != TYPE_RPAREN)
 	{
 		std::shared_ptr<AST_Node> param = parse_arg();
-		node->FUNC_DEF.params.push_back(param);
+		node->FUNC_DEF().params.push_back(param);
 
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing ')' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		if (token->type == TYPE_RPAREN)
@@ -449,68 +493,129 @@ std::shared_ptr<AST_Node> AST_Parser::parse_func_def()
 	if (token->type != TYPE_LBRACE && token->type != TYPE_RIGHT_ARROW)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, node, "Expected '{' or '=>'.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	if (token->type == TYPE_RIGHT_ARROW)
 	{
-		std::vector<std::shared_ptr<AST_Node>> raw_expr;
+		Expression expr;
 
 		advance();
 		while (token->type != TYPE_LBRACE)
 		{
-			std::shared_ptr<AST_Node> atom = parse_atom();
-			raw_expr.push_back(atom);
+			expr.add(parse_atom());
 
 			if (token->type == TYPE_EOF)
 			{
 				error_and_skip_to(TYPE_EOF, node, "Missing '{'. Reached EOF.");
-				return std::make_shared<AST_Node>(TYPE_ERROR);
+				return make_node(arena, TYPE_ERROR);
 			}
 
 			advance();
 		}
 
-		raw_expr.push_back(std::make_shared<AST_Node>(TYPE_END_OF_EXPRESSON));
-
-		std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
+		node->FUNC_DEF().return_type = expr.finish();
+	}
 
-		node->RETURN.value = expr;
+	if (lazy_bodies)
+	{
+		defer_body(node);
+		return node;
 	}
 
 	auto block = parse_block();
-	for (std::shared_ptr<AST_Node> expr : block->BLOCK.body)
+	if (block->type == TYPE_ERROR)
 	{
-		node->FUNC_DEF.body.push_back(expr);
+		return block;
+	}
+
+	for (std::shared_ptr<AST_Node> expr : block->BLOCK().body)
+	{
+		node->FUNC_DEF().body.push_back(expr);
 	}
 
 	return node;
 }
 
+void AST_Parser::defer_body(std::shared_ptr<AST_Node>& node)
+{
+	uint32_t begin = token->offset;
+	int depth = 0;
+
+	while (token->type != TYPE_EOF)
+	{
+		if (token->type == TYPE_LBRACE)
+		{
+			depth++;
+		}
+		else if (token->type == TYPE_RBRACE && --depth == 0)
+		{
+			break;
+		}
+
+		advance();
+	}
+
+	if (token->type == TYPE_EOF)
+	{
+		// The body runs to the end of the source; parsing it alone reads the same tokens
+		Lexer body_lexer(source, file_name, begin, source->view().size());
+		AST_Parser body_parser(body_lexer);
+		auto block = body_parser.parse_block();
+		if (block->type == TYPE_BLOCK)
+		{
+			for (std::shared_ptr<AST_Node> expr : block->BLOCK().body)
+			{
+				node->FUNC_DEF().body.push_back(expr);
+			}
+		}
+
+		warnings.insert(warnings.end(), body_parser.warnings.begin(), body_parser.warnings.end());
+		errors.insert(errors.end(), body_parser.errors.begin(), body_parser.errors.end());
+		return;
+	}
+
+	auto lazy = std::make_shared<Lazy_Body>();
+	lazy->source = source;
+	lazy->file_name = file_name;
+	lazy->begin = begin;
+	lazy->end = token->offset + 1;
+	node->FUNC_DEF().lazy = lazy;
+	lazy_body_stats().deferred++;
+
+	token->type = TYPE_END_OF_EXPRESSON;
+}
+
 std::shared_ptr<AST_Node> AST_Parser::parse_type_def()
 {
 	advance();
 	if (token->type != TYPE_ID)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, token, "Expected identifier.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
-	std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
-	node->type = TYPE_TYPE_DEF;
-	node->TYPE_DEF.name = *token->id_value;
+	std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
+	node->retype(TYPE_TYPE_DEF);
+	node->TYPE_DEF().name = std::string(lexer->tokens.get_id_value(*token));
+	node->TYPE_DEF().id = register_type(node->TYPE_DEF().name);
 
 	advance();
 	if (token->type != TYPE_LBRACE)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, token, "Expected '{'.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	std::shared_ptr<AST_Node> body = parse_block();
-	for (std::shared_ptr<AST_Node> expr : body->BLOCK.body)
+	if (body->type == TYPE_ERROR)
 	{
-		node->TYPE_DEF.body.push_back(expr);
+		return body;
+	}
+
+	for (std::shared_ptr<AST_Node> expr : body->BLOCK().body)
+	{
+		node->TYPE_DEF().body.push_back(expr);
 	}
 
 	return node;
@@ -518,28 +623,33 @@ std::shared_ptr<AST_Node> AST_Parser::parse_type_def()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_while_loop()
 {
-	std::shared_ptr<AST_Node> while_loop = std::make_shared<AST_Node>(TYPE_WHILE);
+	std::shared_ptr<AST_Node> while_loop = make_node(arena, TYPE_WHILE);
 
 	advance();
 	if (token->type != TYPE_LPAREN)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, while_loop, "Expected a '('.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
-	while_loop->WHILE.expr = parse_paren();
+	while_loop->WHILE().expr = parse_paren();
 
 	advance();
 	if (token->type != TYPE_LBRACE)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, while_loop, "Expected a '{'.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	std::shared_ptr<AST_Node> while_body = parse_block();
-	for (auto& expr : while_body->BLOCK.body)
+	if (while_body->type == TYPE_ERROR)
+	{
+		return while_body;
+	}
+
+	for (auto& expr : while_body->BLOCK().body)
 	{
-		while_loop->WHILE.body.push_back(expr);
+		while_loop->WHILE().body.push_back(expr);
 	}
 
 	return while_loop;
@@ -547,53 +657,67 @@ std::shared_ptr<AST_Node> AST_Parser::parse_while_loop()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_if_else_atom()
 {
-	std::shared_ptr<AST_Node> if_atom = std::make_shared<AST_Node>(token);
-	if_atom->type = TYPE_IF;
+	std::shared_ptr<AST_Node> if_atom = make_node(arena, *token, lexer->tokens.text(*token));
+	if_atom->retype(TYPE_IF);
 
 	advance();
 	if (token->type != TYPE_LPAREN)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, if_atom, "Expected a '('.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	std::shared_ptr<AST_Node> if_expr = parse_paren();
-	if_atom->IF.expr = if_expr;
+	if_atom->IF().expr = if_expr;
 
 	advance();
 	if (token->type != TYPE_LBRACE)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, if_atom, "Expected a '{'.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	std::shared_ptr<AST_Node> if_body = parse_block();
-	if_atom->IF.body = if_body;
+	if (if_body->type == TYPE_ERROR)
+	{
+		return if_body;
+	}
+
+	if_atom->IF().body = if_body;
 
 	return if_atom;
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_if_else_statement()
 {
-	std::shared_ptr<AST_Node> if_statement = std::make_shared<AST_Node>(token);
-	if_statement->type = TYPE_IF_ELSE_STATEMENT;
+	std::shared_ptr<AST_Node> if_statement = make_node(arena, *token, lexer->tokens.text(*token));
+	if_statement->retype(TYPE_IF_ELSE_STATEMENT);
 
 	std::shared_ptr<AST_Node> if_atom = parse_if_else_atom();
+	if (if_atom->type == TYPE_ERROR)
+	{
+		return if_atom;
+	}
 
-	if_statement->IF_STATEMENT.statements.push_back(if_atom);
+	if_statement->IF_STATEMENT().statements.push_back(if_atom);
 
-	while (peek()->get_id_value() == "else" && peek(2)->get_id_value() == "if")
+	while (peek()->type == TYPE_KW_ELSE && peek(2)->type == TYPE_KW_IF)
 	{
 		advance();
 		advance();
 		std::shared_ptr<AST_Node> if_else_atom = parse_if_else_atom();
-		if_statement->IF_STATEMENT.statements.push_back(if_else_atom);
+		if (if_else_atom->type == TYPE_ERROR)
+		{
+			return if_else_atom;
+		}
+
+		if_statement->IF_STATEMENT().statements.push_back(if_else_atom);
 	}
 
-	if (peek()->get_id_value() == "else")
+	if (peek()->type == TYPE_KW_ELSE)
 	{
-		std::shared_ptr<AST_Node> else_atom = std::make_shared<AST_Node>(token);
-		else_atom->type = TYPE_ELSE;
+		std::shared_ptr<AST_Node> else_atom = make_node(arena, *token, lexer->tokens.text(*token));
+		else_atom->retype(TYPE_ELSE);
 
 		advance();
 		advance();
@@ -601,17 +725,23 @@ std::shared_ptr<AST_Node> AST_Parser::parse_if_else_statement()
 		if (token->type != TYPE_LBRACE)
 		{
 			error_and_skip_to(TYPE_SEMICOLON, else_atom, "Expected a '{'.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
-		else_atom->IF.body = parse_block();
-		if_statement->IF_STATEMENT.statements.push_back(else_atom);
+		std::shared_ptr<AST_Node> else_body = parse_block();
+		if (else_body->type == TYPE_ERROR)
+		{
+			return else_body;
+		}
+
+		else_atom->IF().body = else_body;
+		if_statement->IF_STATEMENT().statements.push_back(else_atom);
 	}
 
-	if (peek()->get_id_value() == "else")
+	if (peek()->type == TYPE_KW_ELSE)
 	{
 		error_and_skip_to(TYPE_SEMICOLON, peek(), "If/Else Statements cannot have more than one Else block.");
-		return std::make_shared<AST_Node>(TYPE_ERROR);
+		return make_node(arena, TYPE_ERROR);
 	}
 
 	return if_statement;
@@ -619,25 +749,24 @@ std::shared_ptr<AST_Node> AST_Parser::parse_if_else_statement()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_named_block()
 {
-	std::string block_name = std::make_shared<AST_Node>(token)->ID.value;
+	std::string block_name = std::string(lexer->tokens.get_id_value(*token));
 	advance();
-	std::shared_ptr<AST_Node> block = std::make_shared<AST_Node>(token);
-	block->type = TYPE_BLOCK;
-	block->BLOCK.name = block_name;
+	std::shared_ptr<AST_Node> block = make_node(arena, *token, lexer->tokens.text(*token));
+	block->retype(TYPE_BLOCK);
+	block->BLOCK().name = block_name;
 	advance();
 
 	while (token->type != TYPE_RBRACE)
 	{
-		auto raw_expr = build_expression();
-		std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
+		std::shared_ptr<AST_Node> expr = parse_expression();
 
 		if (expr->type != TYPE_ERROR)
-			block->BLOCK.body.push_back(expr);
+			block->BLOCK().body.push_back(expr);
 
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing '}' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		advance();
@@ -650,22 +779,21 @@ std::shared_ptr<AST_Node> AST_Parser::parse_named_block()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_block()
 {
-	std::shared_ptr<AST_Node> block = std::make_shared<AST_Node>(token);
-	block->type = TYPE_BLOCK;
+	std::shared_ptr<AST_Node> block = make_node(arena, *token, lexer->tokens.text(*token));
+	block->retype(TYPE_BLOCK);
 	advance();
 
 	while (token->type != TYPE_RBRACE)
 	{
-		auto raw_expr = build_expression();
-		std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
+		std::shared_ptr<AST_Node> expr = parse_expression();
 
 		if (expr->type != TYPE_ERROR)
-			block->BLOCK.body.push_back(expr);
+			block->BLOCK().body.push_back(expr);
 
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing '}' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		advance();
@@ -680,48 +808,43 @@ std::shared_ptr<AST_Node> AST_Parser::parse_paren()
 {
 	advance();
 
-	std::vector<std::shared_ptr<AST_Node>> raw_expr;
+	Expression expr;
 
 	while (token->type != TYPE_RPAREN)
 	{
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing ')' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		if (token->type == TYPE_SEMICOLON)
 		{
 			advance();
 			error_and_skip_to(TYPE_SEMICOLON, token, "Expected ')'. Cannot have ';' inside parentheses.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		if (token->type == TYPE_LPAREN)
 		{
-			std::shared_ptr<AST_Node> p_exp = parse_paren();
-			raw_expr.push_back(p_exp);
+			expr.add(parse_paren());
 			advance();
 			continue;
 		}
 
-		std::shared_ptr<AST_Node> atom = parse_atom();
-		raw_expr.push_back(atom);
+		expr.add(parse_atom());
 
 		advance();
 	}
 
-	std::shared_ptr<AST_Node> end_of_expression = std::make_shared<AST_Node>(TYPE_END_OF_EXPRESSON);
-	raw_expr.push_back(end_of_expression);
-
-	std::shared_ptr<AST_Node> node = parse_expression(raw_expr);
+	std::shared_ptr<AST_Node> node = expr.finish();
 	node->is_p_expr = true;
 	return node;
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_unary_op()
 {
-	std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
+	std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
 
 	if (node->type == TYPE_PLUS)
 		node->type = TYPE_POS;
@@ -748,32 +871,29 @@ std::shared_ptr<AST_Node> AST_Parser::parse_unary_op()
 
 std::shared_ptr<AST_Node> AST_Parser::parse_arg()
 {
-	std::vector<std::shared_ptr<AST_Node>> raw_expr;
+	Expression expr;
 
 	while (token->type != TYPE_COMMA && token->type != TYPE_RPAREN)
 	{
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing ')' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
-		std::shared_ptr<AST_Node> atom = parse_atom();
-		raw_expr.push_back(atom);
+		expr.add(parse_atom());
 		advance();
 	}
 
-	raw_expr.push_back(std::make_shared<AST_Node>(TYPE_END_OF_EXPRESSON));
-
-	std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
-	return expr;
+	return expr.finish();
 }
 
 std::shared_ptr<AST_Node> AST_Parser::parse_call()
 {
-	std::shared_ptr<AST_Node> node = std::make_shared<AST_Node>(token);
-	node->type = TYPE_CALL;
-	node->CALL.name = node->ID.value;
+	std::shared_ptr<AST_Node> node = make_node(arena, *token, lexer->tokens.text(*token));
+	std::string name = std::move(node->ID().value);
+	node->retype(TYPE_CALL);
+	node->CALL().name = std::move(name);
 
 	advance();
 	advance();
@@ -781,12 +901,12 @@ std::shared_ptr<AST_Node> AST_Parser::parse_call()
 	while (token->type != TYPE_RPAREN)
 	{
 		std::shared_ptr<AST_Node> arg = parse_arg();
-		node->CALL.args.push_back(arg);
+		node->CALL().args.push_back(arg);
 
 		if (token->type == TYPE_EOF)
 		{
 			error_and_skip_to(TYPE_EOF, token, "Missing ')' - Reached EOF.");
-			return std::make_shared<AST_Node>(TYPE_ERROR);
+			return make_node(arena, TYPE_ERROR);
 		}
 
 		if (token->type == TYPE_RPAREN)
@@ -804,8 +924,7 @@ void AST_Parser::parse()
 {
 	while (token->type != TYPE_EOF)
 	{
-		std::vector<std::shared_ptr<AST_Node>> raw_expr = build_expression();
-		std::shared_ptr<AST_Node> expr = parse_expression(raw_expr);
+		std::shared_ptr<AST_Node> expr = parse_expression();
 		if (expr->type != TYPE_ERROR && expr->type != TYPE_EMPTY)
 			expressions.push_back(expr);
 		advance();
@@ -813,4 +932,59 @@ void AST_Parser::parse()
 
 	check_for_warnings();
 	check_for_errors();
-}
\ No newline at end of file
+}
+Lazy_Body_Stats& lazy_body_stats()
+{
+	static Lazy_Body_Stats stats;
+	return stats;
+}
+
+bool materialize_body(Func_Def_Node& func)
+{
+	if (!func.lazy)
+	{
+		return true;
+	}
+
+	Lazy_Body& lazy = *func.lazy;
+	if (lazy.failed)
+	{
+		return false;
+	}
+
+	if (!lazy.materialized)
+	{
+		Lexer lexer(lazy.source, lazy.file_name, lazy.begin, lazy.end);
+		AST_Parser parser(lexer);
+		auto block = parser.parse_block();
+		parser.check_for_warnings();
+		parser.check_for_errors();
+
+		// The function keeps its lazy body, so copies of it fail the same way
+		if (lexer.has_errors || parser.has_errors || block->type != TYPE_BLOCK)
+		{
+			lazy.failed = true;
+			return false;
+		}
+
+		func.body = block->BLOCK().body;
+		if (lazy.resolve)
+		{
+			AST_Resolver resolver;
+			func.slots = resolver.resolve_function(func);
+		}
+
+		lazy.body = func.body;
+		lazy.slots = func.slots;
+		lazy.materialized = true;
+		lazy_body_stats().materialized++;
+	}
+	else
+	{
+		func.body = lazy.body;
+		func.slots = lazy.slots;
+	}
+
+	func.lazy = nullptr;
+	return true;
+}
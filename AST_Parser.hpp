@@ -4,13 +4,36 @@
 #include "AST_Node.hpp"
 #include "Lexer.hpp"
 
+// Builds an expression tree as its atoms are parsed, in one pass. Each node walks down the
+// right edge of the tree and takes over the first subtree it binds no tighter than; otherwise
+// it becomes the operand at the bottom. Parenthesised subtrees are always taken over.
+class Expression
+{
+	std::shared_ptr<AST_Node> root = nullptr;
+	std::shared_ptr<AST_Node> error = nullptr;
+
+public:
+
+	void add(std::shared_ptr<AST_Node> node);
+
+	// The tree, the first error added, or an empty node if nothing was added
+	std::shared_ptr<AST_Node> finish();
+};
+
 class AST_Parser
 {
 public:
 	std::string file_name;
-	std::vector<std::shared_ptr<Token>> tokens;
+	// Tokens are pulled from the lexer as parsing goes
+	Lexer* lexer = nullptr;
 	int index = 0;
-	std::shared_ptr<Token> token = nullptr;
+	Token* token = nullptr;
+
+	// Turns token and node offsets into lines and columns for messages
+	std::shared_ptr<Source_Buffer> source;
+
+	// Tokens kept while streaming; must cover the deepest peek() and backtack()
+	static const size_t TOKEN_WINDOW = 64;
 
 	std::vector<std::string> warnings;
 	std::vector<std::string> errors;
@@ -18,29 +41,37 @@ public:
 
 	bool debug = false;
 
+	// Function bodies are skipped by brace matching and parsed on first call
+	bool lazy_bodies = true;
+
 	std::vector<std::shared_ptr<AST_Node>> expressions;
 
+	// Every node of this parse unit is allocated here
+	std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+
 	AST_Parser() = default;
 
-	AST_Parser(std::vector<std::shared_ptr<Token>>& tokens, std::string file_name);
+	// If 'lexer' hasn't tokenized yet, it's streamed and only a window of tokens is kept.
+	// The lexer must outlive parsing.
+	AST_Parser(Lexer& lexer);
 
-	AST_Parser(Lexer lexer);
+	Token* token_at(int position);
 
 	void advance();
 
 	void backtack();
 
-	std::shared_ptr<Token> peek(int n = 1);
+	Token* peek(int n = 1);
 
 	// ---- Error Handling ---- //
 
 	void error_and_skip_to(Type type, std::shared_ptr<AST_Node> error_node, std::string message);
 
-	void error_and_skip_to(Type type, std::shared_ptr<Token> error_token, std::string message);
+	void error_and_skip_to(Type type, Token* error_token, std::string message);
 
 	void warn_and_skip_to(Type type, std::shared_ptr<AST_Node> warning_node, std::string message);
 
-	void warn_and_skip_to(Type type, std::shared_ptr<Token> warning_token, std::string message);
+	void warn_and_skip_to(Type type, Token* warning_token, std::string message);
 
 	void check_for_warnings();
 
@@ -48,50 +79,8 @@ public:
 
 	// ---- Parsing ---- //
 
-	std::unordered_map<Type, int> precedence
-	{
-		{ TYPE_EQUAL,					300 },
-		{ TYPE_EQ_AND,					300 },
-		{ TYPE_AND,						200 },
-		{ TYPE_OR,						200 },
-		{ TYPE_RIGHT_ARROW,				180 },
-		{ TYPE_RIGHT_ARROW_SINGLE,		180 },
-		{ TYPE_COMMA,					170 },
-		{ TYPE_PLUS_EQ,					150 },
-		{ TYPE_MINUS_EQ,				150 },
-		{ TYPE_EQ_EQ,					100 },
-		{ TYPE_NOT_EQUAL,				100 },
-		{ TYPE_LT_EQUAL,				100 },
-		{ TYPE_GT_EQUAL,				100 },
-		{ TYPE_LANGLE,					100 },
-		{ TYPE_RANGLE,					100 },
-		{ TYPE_PLUS,					 40 },
-		{ TYPE_MINUS,					 40 },
-		{ TYPE_STAR,					 30 },
-		{ TYPE_SLASH,					 30 },
-		{ TYPE_POS,						 20 },
-		{ TYPE_NEG,						 20 },
-		{ TYPE_PLUS_PLUS,				  5 },
-		{ TYPE_MINUS_MINUS,				  5 },
-		{ TYPE_DOT,						  2 },
-		{ TYPE_DOUBLE_COLON,			  2 },
-		{ TYPE_COLON,					  2 },
-		{ TYPE_CALL,					  1 },
-		{ TYPE_ID,						  1 },
-		{ TYPE_INT,						  1 },
-		{ TYPE_FLOAT,					  1 },
-		{ TYPE_STRING,					  1 },
-		{ TYPE_TYPE,					  1 },
-		{ TYPE_RANGE,					  1 },
-		{ TYPE_LIST,					  1 },
-		{ TYPE_BOOL,					  1 },
-	};
-
-	std::shared_ptr<AST_Node> parse_expression(std::vector<std::shared_ptr<AST_Node>> raw_expression);
-
-	void insert_in_ast(std::shared_ptr<AST_Node>& root, std::shared_ptr<AST_Node>& node);
-
-	std::vector<std::shared_ptr<AST_Node>> build_expression();
+	// Parses atoms up to the ';' ending the statement, or up to a block that ends it
+	std::shared_ptr<AST_Node> parse_expression();
 
 	std::shared_ptr<AST_Node> parse_atom();
 
@@ -103,6 +92,10 @@ public:
 
 	std::shared_ptr<AST_Node> parse_func_def();
 
+	// Skips the body starting at the current '{', recording its range in 'node'. A body whose
+	// braces don't balance is parsed right away, so its errors are reported as before.
+	void defer_body(std::shared_ptr<AST_Node>& node);
+
 	std::shared_ptr<AST_Node> parse_type_def();
 
 	std::shared_ptr<AST_Node> parse_while_loop();
@@ -125,3 +118,18 @@ public:
 
 	void parse();
 };
+
+// Function bodies deferred by every parse in the process, and how many were parsed later.
+// The rest were never needed.
+struct Lazy_Body_Stats
+{
+	int deferred = 0;
+	int materialized = 0;
+};
+
+Lazy_Body_Stats& lazy_body_stats();
+
+// Parses and resolves a deferred function body the first time it's needed. Does nothing for
+// bodies that were parsed with the rest of the tree. Returns false if the body has syntax errors,
+// which are reported on the first attempt only.
+bool materialize_body(Func_Def_Node& func);
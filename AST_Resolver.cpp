@@ -0,0 +1,219 @@
+#include "AST_Resolver.hpp"
+
+// ########### DECLARATIONS ########### //
+
+void AST_Resolver::declare(std::shared_ptr<AST_Node>& node)
+{
+	if (!node)
+	{
+		return;
+	}
+
+	auto& block = blocks.back();
+
+	switch (node->type)
+	{
+	case TYPE_EQUAL:
+		if (node->left && node->left->type == TYPE_ID)
+		{
+			block.slots.emplace(node->left->ID().symbol, (int)block.slots.size());
+		}
+		else
+		{
+			declare(node->left);
+		}
+		declare(node->right);
+		return;
+	case TYPE_DOUBLE_COLON:
+		declare(node->left);
+		return;
+	case TYPE_FUNC_DEF:
+		block.dynamic.insert(intern(node->FUNC_DEF().name));
+		return;
+	case TYPE_BLOCK:
+		if (!node->BLOCK().name.empty())
+		{
+			block.dynamic.insert(intern(node->BLOCK().name));
+		}
+		return;
+	case TYPE_TYPE_DEF:
+		return;
+	case TYPE_IF_ELSE_STATEMENT:
+		// If and while bodies run in the enclosing scope
+		for (auto& if_stmnt : node->IF_STATEMENT().statements)
+		{
+			declare(if_stmnt->IF().expr);
+			declare_body(if_stmnt->IF().body->BLOCK().body);
+		}
+		return;
+	case TYPE_WHILE:
+		declare(node->WHILE().expr);
+		declare_body(node->WHILE().body);
+		return;
+	default:
+		declare(node->left);
+		declare(node->right);
+		if (auto call = node->find_payload<Call_Node>())
+		{
+			declare_body(call->args);
+		}
+		if (auto list = node->find_payload<List_Node>())
+		{
+			declare_body(list->items);
+		}
+		if (auto ret = node->find_payload<Return_Node>())
+		{
+			declare(ret->value);
+		}
+		return;
+	}
+}
+
+void AST_Resolver::declare_body(std::vector<std::shared_ptr<AST_Node>>& body)
+{
+	for (auto& expr : body)
+	{
+		declare(expr);
+	}
+}
+
+// ########### RESOLUTION ########### //
+
+void AST_Resolver::resolve_id(ID_Node& id)
+{
+	for (int i = blocks.size() - 1; i >= function_base; i--)
+	{
+		auto& block = blocks[i];
+
+		if (block.dynamic.count(id.symbol))
+		{
+			return;
+		}
+
+		auto slot = block.slots.find(id.symbol);
+		if (slot != block.slots.end())
+		{
+			id.depth = blocks.size() - 1 - i;
+			id.slot = slot->second;
+			return;
+		}
+	}
+}
+
+void AST_Resolver::resolve_node(std::shared_ptr<AST_Node>& node)
+{
+	if (!node)
+	{
+		return;
+	}
+
+	switch (node->type)
+	{
+	case TYPE_ID:
+		resolve_id(node->ID());
+		return;
+	case TYPE_DOUBLE_COLON:
+		// The right side is looked up in whatever scope the left side evaluates to
+		resolve_node(node->left);
+		return;
+	case TYPE_BLOCK:
+		node->BLOCK().slots = resolve_block(node->BLOCK().body);
+		return;
+	case TYPE_FUNC_DEF:
+	{
+		if (node->FUNC_DEF().lazy)
+		{
+			node->FUNC_DEF().lazy->resolve = true;
+			return;
+		}
+
+		int outer_base = function_base;
+		function_base = blocks.size();
+		node->FUNC_DEF().slots = resolve_block(node->FUNC_DEF().body, &node->FUNC_DEF().params);
+		function_base = outer_base;
+		return;
+	}
+	case TYPE_TYPE_DEF:
+		return;
+	case TYPE_IF_ELSE_STATEMENT:
+		for (auto& if_stmnt : node->IF_STATEMENT().statements)
+		{
+			resolve_node(if_stmnt->IF().expr);
+			resolve_body(if_stmnt->IF().body->BLOCK().body);
+		}
+		return;
+	case TYPE_WHILE:
+		resolve_node(node->WHILE().expr);
+		resolve_body(node->WHILE().body);
+		return;
+	default:
+		resolve_node(node->left);
+		resolve_node(node->right);
+		if (auto call = node->find_payload<Call_Node>())
+		{
+			resolve_body(call->args);
+		}
+		if (auto list = node->find_payload<List_Node>())
+		{
+			resolve_body(list->items);
+		}
+		if (auto ret = node->find_payload<Return_Node>())
+		{
+			resolve_node(ret->value);
+		}
+		return;
+	}
+}
+
+void AST_Resolver::resolve_body(std::vector<std::shared_ptr<AST_Node>>& body)
+{
+	for (auto& expr : body)
+	{
+		resolve_node(expr);
+	}
+}
+
+int AST_Resolver::resolve_block(std::vector<std::shared_ptr<AST_Node>>& body, std::vector<std::shared_ptr<AST_Node>>* params)
+{
+	blocks.push_back({});
+
+	// Parameters are bound in order, so they take the first slots
+	if (params)
+	{
+		for (auto& param : *params)
+		{
+			if (param->type != TYPE_ID)
+			{
+				continue;
+			}
+
+			auto slot = blocks.back().slots.emplace(param->ID().symbol, (int)blocks.back().slots.size());
+			if (slot.second)
+			{
+				param->ID().depth = 0;
+				param->ID().slot = slot.first->second;
+			}
+		}
+	}
+
+	declare_body(body);
+	resolve_body(body);
+
+	int slots = blocks.back().slots.size();
+	blocks.pop_back();
+	return slots;
+}
+
+int AST_Resolver::resolve(std::vector<std::shared_ptr<AST_Node>>& expressions)
+{
+	blocks.clear();
+	function_base = 0;
+	return resolve_block(expressions);
+}
+
+int AST_Resolver::resolve_function(Func_Def_Node& func)
+{
+	blocks.clear();
+	function_base = 0;
+	return resolve_block(func.body, &func.params);
+}
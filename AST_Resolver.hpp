@@ -0,0 +1,42 @@
+#pragma once
+#include <unordered_set>
+#include "AST_Node.hpp"
+
+// Runs between parsing and evaluation. Each block and function body gets a slot per name
+// assigned in it, and each ID that can only refer to one of those slots is annotated with
+// (depth, slot). Resolution never crosses a function body: a function's scope is parented
+// to its caller's at runtime, so everything outside it stays a dynamic lookup.
+class AST_Resolver
+{
+	struct Block
+	{
+		std::unordered_map<int, int> slots;
+
+		// Names bound by 'def' or named blocks, which don't get slots
+		std::unordered_set<int> dynamic;
+	};
+
+	std::vector<Block> blocks;
+	int function_base = 0;
+
+	void declare(std::shared_ptr<AST_Node>& node);
+
+	void declare_body(std::vector<std::shared_ptr<AST_Node>>& body);
+
+	void resolve_id(ID_Node& id);
+
+	void resolve_node(std::shared_ptr<AST_Node>& node);
+
+	void resolve_body(std::vector<std::shared_ptr<AST_Node>>& body);
+
+	int resolve_block(std::vector<std::shared_ptr<AST_Node>>& body, std::vector<std::shared_ptr<AST_Node>>* params = nullptr);
+
+public:
+
+	// Returns the number of slots the global scope needs
+	int resolve(std::vector<std::shared_ptr<AST_Node>>& expressions);
+
+	// Resolves a function body parsed after the rest of the tree. Returns the number of
+	// slots its scope needs.
+	int resolve_function(Func_Def_Node& func);
+};
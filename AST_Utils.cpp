@@ -1,4 +1,5 @@
 #include "AST_Utils.hpp"
+#include "AST_Parser.hpp"
 
 void print_ast_node(std::shared_ptr<AST_Node> node)
 {
@@ -16,7 +17,7 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_STRING)
 	{
-		std::cout << node->STRING.value;
+		std::cout << node->STRING().value;
 	}
 	else if (node->type == TYPE_BOOL)
 	{
@@ -24,11 +25,11 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_ID)
 	{
-		std::cout << node->ID.value;
+		std::cout << node->ID().value;
 	}
 	else if (node->type == TYPE_VAR)
 	{
-		print_ast_node(node->VAR.value);
+		print_ast_node(node->VAR().get());
 	}
 	else if (node->type == TYPE_DOT)
 	{
@@ -64,12 +65,12 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_CALL)
 	{
-		std::cout << type_repr(node->type) << "(name: " << node->CALL.name << ", args: [ ";
-		for (int i = 0; i < node->CALL.args.size(); i++)
+		std::cout << type_repr(node->type) << "(name: " << node->CALL().name << ", args: [ ";
+		for (size_t i = 0; i < node->CALL().args.size(); i++)
 		{
-			print_ast_node(node->CALL.args[i]);
+			print_ast_node(node->CALL().args[i]);
 
-			if (i != node->CALL.args.size() - 1)
+			if (i != node->CALL().args.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -81,11 +82,11 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	{
 		std::cout << type_repr(node->type) << "(statements: [ ";
 
-		for (int i = 0; i < node->BLOCK.body.size(); i++)
+		for (size_t i = 0; i < node->BLOCK().body.size(); i++)
 		{
-			print_ast_node(node->BLOCK.body[i]);
+			print_ast_node(node->BLOCK().body[i]);
 
-			if (i != node->BLOCK.body.size() - 1)
+			if (i != node->BLOCK().body.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -96,14 +97,14 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	else if (node->type == TYPE_IF)
 	{
 		std::cout << type_repr(node->type) << "(expression: ";
-		print_ast_node(node->IF.expr);
+		print_ast_node(node->IF().expr);
 		std::cout << ", body: [ ";
 
-		for (int i = 0; i < node->IF.body->BLOCK.body.size(); i++)
+		for (size_t i = 0; i < node->IF().body->BLOCK().body.size(); i++)
 		{
-			print_ast_node(node->IF.body->BLOCK.body[i]);
+			print_ast_node(node->IF().body->BLOCK().body[i]);
 
-			if (i != node->IF.body->BLOCK.body.size() - 1)
+			if (i != node->IF().body->BLOCK().body.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -115,11 +116,11 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	{
 		std::cout << type_repr(node->type) << "(body: [ ";
 
-		for (int i = 0; i < node->IF.body->BLOCK.body.size(); i++)
+		for (size_t i = 0; i < node->IF().body->BLOCK().body.size(); i++)
 		{
-			print_ast_node(node->IF.body->BLOCK.body[i]);
+			print_ast_node(node->IF().body->BLOCK().body[i]);
 
-			if (i != node->IF.body->BLOCK.body.size() - 1)
+			if (i != node->IF().body->BLOCK().body.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -130,10 +131,10 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	else if (node->type == TYPE_IF_ELSE_STATEMENT)
 	{
 		std::cout << type_repr(node->type) << "( ";
-		for (int i = 0; i < node->IF_STATEMENT.statements.size(); i++)
+		for (size_t i = 0; i < node->IF_STATEMENT().statements.size(); i++)
 		{
-			print_ast_node(node->IF_STATEMENT.statements[i]);
-			if (i != node->IF_STATEMENT.statements.size() - 1)
+			print_ast_node(node->IF_STATEMENT().statements[i]);
+			if (i != node->IF_STATEMENT().statements.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -143,14 +144,14 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_TYPE_DEF)
 	{
-		std::cout << type_repr(node->type) << "(type name: " << node->TYPE_DEF.name;
+		std::cout << type_repr(node->type) << "(type name: " << node->TYPE_DEF().name;
 		std::cout << ", body: [ ";
 
-		for (int i = 0; i < node->TYPE_DEF.body.size(); i++)
+		for (size_t i = 0; i < node->TYPE_DEF().body.size(); i++)
 		{
-			print_ast_node(node->TYPE_DEF.body[i]);
+			print_ast_node(node->TYPE_DEF().body[i]);
 
-			if (i != node->TYPE_DEF.body.size() - 1)
+			if (i != node->TYPE_DEF().body.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -160,15 +161,15 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_FUNC_DEF)
 	{
-		std::cout << type_repr(node->type) << "(func name: " << node->FUNC_DEF.name;
+		std::cout << type_repr(node->type) << "(func name: " << node->FUNC_DEF().name;
 
 		std::cout << ", params: [ ";
 
-		for (int i = 0; i < node->FUNC_DEF.params.size(); i++)
+		for (size_t i = 0; i < node->FUNC_DEF().params.size(); i++)
 		{
-			print_ast_node(node->FUNC_DEF.params[i]);
+			print_ast_node(node->FUNC_DEF().params[i]);
 
-			if (i != node->FUNC_DEF.params.size() - 1)
+			if (i != node->FUNC_DEF().params.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -176,18 +177,19 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 
 		std::cout << " ], return_type: ";
 
-		if (node->FUNC_DEF.return_type == nullptr)
+		if (node->FUNC_DEF().return_type == nullptr)
 			std::cout << "NONE";
 		else
-			print_ast_node(node->FUNC_DEF.return_type);
+			print_ast_node(node->FUNC_DEF().return_type);
 
 		std::cout << " , body: [ ";
 
-		for (int i = 0; i < node->FUNC_DEF.body.size(); i++)
+		materialize_body(node->FUNC_DEF());
+		for (size_t i = 0; i < node->FUNC_DEF().body.size(); i++)
 		{
-			print_ast_node(node->FUNC_DEF.body[i]);
+			print_ast_node(node->FUNC_DEF().body[i]);
 
-			if (i != node->FUNC_DEF.body.size() - 1)
+			if (i != node->FUNC_DEF().body.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -198,17 +200,17 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	else if (node->type == TYPE_RETURN)
 	{
 		std::cout << type_repr(node->type) << "( ";
-		print_ast_node(node->RETURN.value);
+		print_ast_node(node->RETURN().value);
 		std::cout << " )";
 	}
 	else if (node->type == TYPE_LIST)
 	{
 		std::cout << type_repr(node->type) << "[ ";
-		for (int i = 0; i < node->LIST.items.size(); i++)
+		for (size_t i = 0; i < node->LIST().items.size(); i++)
 		{
-			print_ast_node(node->LIST.items[i]);
+			print_ast_node(node->LIST().items[i]);
 
-			if (i != node->LIST.items.size() - 1)
+			if (i != node->LIST().items.size() - 1)
 			{
 				std::cout << ", ";
 			}
@@ -245,10 +247,10 @@ void print_ast_node(std::shared_ptr<AST_Node> node)
 	}
 	else if (node->type == TYPE_SCOPE)
 	{
-		std::cout << type_repr(node->type) << "(" << node->SCOPE.parent->SCOPE.name << "::" << node->SCOPE.name << ")";
+		std::cout << type_repr(node->type) << "(" << node->SCOPE().parent->SCOPE().name << "::" << node->SCOPE().name << ")";
 	}
 	else if (node->type == TYPE_TYPE)
 	{
-		std::cout << node->TYPE.name;
+		std::cout << type_name(node->TYPE().id);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include "Arena.hpp"
+
+void* Arena::allocate(size_t size, size_t align)
+{
+	size_t padding = (0 - (uintptr_t)current) & (align - 1);
+
+	if (padding + size > remaining)
+	{
+		size_t block_size = size + align > BLOCK_SIZE ? size + align : BLOCK_SIZE;
+		blocks.emplace_back(new char[block_size]);
+		current = blocks.back().get();
+		remaining = block_size;
+		padding = (0 - (uintptr_t)current) & (align - 1);
+	}
+
+	void* ptr = current + padding;
+	current += padding + size;
+	remaining -= padding + size;
+	allocated += size;
+	allocations++;
+	return ptr;
+}
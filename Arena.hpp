@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for everything one parse unit creates. Individual frees are no-ops; all
+// blocks are released together when the Arena is destroyed.
+class Arena
+{
+	std::vector<std::unique_ptr<char[]>> blocks;
+	char* current = nullptr;
+	size_t remaining = 0;
+
+public:
+
+	static const size_t BLOCK_SIZE = 256 * 1024;
+
+	size_t allocated = 0;
+	size_t allocations = 0;
+
+	void* allocate(size_t size, size_t align);
+
+	size_t block_count() { return blocks.size(); }
+};
+
+// Standard allocator over an Arena. Each copy keeps the arena alive, so objects made with
+// std::allocate_shared (whose control blocks hold a copy) can safely outlive the parser.
+template <typename T>
+struct Arena_Allocator
+{
+	using value_type = T;
+
+	std::shared_ptr<Arena> arena;
+
+	Arena_Allocator(std::shared_ptr<Arena> arena) : arena(arena) {}
+
+	template <typename U>
+	Arena_Allocator(const Arena_Allocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t n)
+	{
+		return (T*)arena->allocate(n * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T*, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const Arena_Allocator<T>& a, const Arena_Allocator<U>& b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const Arena_Allocator<T>& a, const Arena_Allocator<U>& b) { return a.arena != b.arena; }
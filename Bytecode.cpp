@@ -0,0 +1,56 @@
+#include "Bytecode.hpp"
+
+std::string op_repr(Op op)
+{
+	switch (op)
+	{
+	case OP_CONSTANT:			return "CONSTANT";
+	case OP_POP:				return "POP";
+	case OP_LOAD:				return "LOAD";
+	case OP_LOAD_VALUE:			return "LOAD_VALUE";
+	case OP_STORE:				return "STORE";
+	case OP_STORE_POP:			return "STORE_POP";
+	case OP_STORE_VAR:			return "STORE_VAR";
+	case OP_ACCESS:				return "ACCESS";
+
+	case OP_ADD:				return "ADD";
+	case OP_SUB:				return "SUB";
+	case OP_MUL:				return "MUL";
+	case OP_DIV:				return "DIV";
+	case OP_NEG:				return "NEG";
+	case OP_POS:				return "POS";
+	case OP_EQ:					return "EQ";
+	case OP_NOT_EQ:				return "NOT_EQ";
+
+	case OP_ENTER_SCOPE:		return "ENTER_SCOPE";
+	case OP_EXIT_SCOPE:			return "EXIT_SCOPE";
+	case OP_JUMP:				return "JUMP";
+	case OP_JUMP_IF_FALSE:		return "JUMP_IF_FALSE";
+
+	case OP_DEF:				return "DEF";
+	case OP_LOAD_FUNC:			return "LOAD_FUNC";
+	case OP_CALL:				return "CALL";
+	case OP_RETURN:				return "RETURN";
+
+	case OP_PRINT:				return "PRINT";
+	case OP_TYPE_OF:			return "TYPE_OF";
+	case OP_STR:				return "STR";
+	case OP_REF:				return "REF";
+	case OP_IMPORT:				return "IMPORT";
+	case OP_BUILTIN_ERROR:		return "BUILTIN_ERROR";
+
+	case OP_END_STATEMENT:		return "END_STATEMENT";
+	case OP_HALT:				return "HALT";
+
+	default: return "NO_REPR";
+	}
+}
+
+void print_chunk(Chunk& chunk)
+{
+	std::cout << "\nChunk: " << std::to_string(chunk.code.size()) << " instruction(s)";
+	for (size_t i = 0; i < chunk.code.size(); i++)
+	{
+		std::cout << "\n" << i << "\t" << op_repr(chunk.code[i].op) << " " << chunk.code[i].arg;
+	}
+}
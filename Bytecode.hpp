@@ -0,0 +1,99 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Type.hpp"
+#include "AST_Node.hpp"
+
+enum Op : unsigned char
+{
+	OP_CONSTANT,
+	OP_POP,
+	OP_LOAD,
+	OP_LOAD_VALUE,
+	OP_STORE,
+	OP_STORE_POP,
+	OP_STORE_VAR,
+	OP_ACCESS,
+
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_NEG,
+	OP_POS,
+	OP_EQ,
+	OP_NOT_EQ,
+
+	OP_ENTER_SCOPE,
+	OP_EXIT_SCOPE,
+	OP_JUMP,
+	OP_JUMP_IF_FALSE,
+
+	OP_DEF,
+	OP_LOAD_FUNC,
+	OP_CALL,
+	OP_RETURN,
+
+	OP_PRINT,
+	OP_TYPE_OF,
+	OP_STR,
+	OP_REF,
+	OP_IMPORT,
+	OP_BUILTIN_ERROR,
+
+	OP_END_STATEMENT,
+	OP_HALT
+};
+
+// 'arg' is a constant index, a node index, a jump target or a count, depending on 'op'.
+struct Instruction
+{
+	Op op;
+	int arg = 0;
+};
+
+// Ints, floats and bools are carried unboxed. Everything else (strings, lists, scopes,
+// vars, types, errors) is carried as the same AST_Node the tree walker would produce.
+struct VM_Value
+{
+	Type type = TYPE_EMPTY;
+	union
+	{
+		int64_t int_value = 0;
+		double float_value;
+		bool bool_value;
+	};
+	std::shared_ptr<AST_Node> node = nullptr;
+
+	VM_Value() = default;
+	VM_Value(int64_t value) : type(TYPE_INT), int_value(value) {}
+	VM_Value(double value) : type(TYPE_FLOAT), float_value(value) {}
+	VM_Value(bool value) : type(TYPE_BOOL), bool_value(value) {}
+	VM_Value(std::shared_ptr<AST_Node> node) : type(node->type), node(node) {}
+};
+
+// Inline cache for name lookups: 'var' is valid while the VM is still in the same activation
+// of 'scope' and no definition that could shadow it ('def', named blocks) has happened since
+// 'epoch'. It owns neither, so a cached call frame and its param vars can still be reused.
+struct VM_Cache
+{
+	AST_Node* scope = nullptr;
+	size_t activation = 0;
+	AST_Node* var = nullptr;
+	std::weak_ptr<AST_Node> var_ref;
+	size_t epoch = 0;
+};
+
+struct Chunk
+{
+	std::vector<Instruction> code;
+	std::vector<VM_Value> constants;
+
+	// Source nodes referenced by instructions, for names, call sites and error positions
+	std::vector<std::shared_ptr<AST_Node>> nodes;
+	std::vector<VM_Cache> caches;
+};
+
+std::string op_repr(Op op);
+
+void print_chunk(Chunk& chunk);
@@ -1,16 +1,167 @@
 #include "Lexer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <thread>
 
-void Lexer::load_source(std::string filename)
+// ########### CHARACTER TABLES ########### //
+
+// Operators and punctuation, longest match first within each leading character
+struct Operator
+{
+	const char* text;
+	Type type;
+};
+
+constexpr Operator OPERATORS[] =
+{
+	{ "==", TYPE_EQ_EQ },			{ "=>", TYPE_RIGHT_ARROW },		{ "=&", TYPE_EQ_AND },		{ "=", TYPE_EQUAL },
+	{ "!=", TYPE_NOT_EQUAL },		{ "!", TYPE_EXCLAMATION },
+	{ "<=", TYPE_LT_EQUAL },		{ "<", TYPE_LANGLE },
+	{ ">=", TYPE_GT_EQUAL },		{ ">", TYPE_RANGLE },
+	{ "+=", TYPE_PLUS_EQ },			{ "++", TYPE_PLUS_PLUS },		{ "+", TYPE_PLUS },
+	{ "-=", TYPE_MINUS_EQ },		{ "--", TYPE_MINUS_MINUS },		{ "->", TYPE_RIGHT_ARROW_SINGLE },	{ "-", TYPE_MINUS },
+	{ "::", TYPE_DOUBLE_COLON },	{ ":", TYPE_COLON },
+	{ "&&", TYPE_AND },				{ "&", TYPE_B_AND },
+	{ "||", TYPE_OR },				{ "|", TYPE_B_OR },
+	{ "(", TYPE_LPAREN },			{ ")", TYPE_RPAREN },
+	{ "{", TYPE_LBRACE },			{ "}", TYPE_RBRACE },
+	{ "[", TYPE_LBRACKET },			{ "]", TYPE_RBRACKET },
+	{ ".", TYPE_DOT },				{ ",", TYPE_COMMA },			{ ";", TYPE_SEMICOLON },
+	{ "\\", TYPE_BACKSLASH },		{ "'", TYPE_APOSTROPHE },		{ "@", TYPE_AT },
+	{ "#", TYPE_HASH },				{ "$", TYPE_DOLLAR },			{ "^", TYPE_CARET },
+	{ "?", TYPE_QUESTION },			{ "%", TYPE_PERCENT },
+	{ "/", TYPE_SLASH },			{ "*", TYPE_STAR },
+};
+
+enum Char_Class : unsigned char
+{
+	CHAR_OTHER,
+	CHAR_NEWLINE,
+	CHAR_SPACE,
+	CHAR_IDENTIFIER,
+	CHAR_DIGIT,
+	CHAR_QUOTE,
+	CHAR_SLASH,
+	CHAR_OPERATOR,
+};
+
+const int MAX_OPERATOR_PAIRS = 4;
+
+struct Operator_Entry
+{
+	Type single = TYPE_EMPTY;
+	int pair_count = 0;
+	char second[MAX_OPERATOR_PAIRS] = {};
+	Type pair[MAX_OPERATOR_PAIRS] = {};
+};
+
+struct Lexer_Tables
+{
+	Char_Class classes[256] = {};
+	Operator_Entry operators[256] = {};
+};
+
+constexpr Lexer_Tables build_lexer_tables()
 {
-	std::ifstream stream(filename);
-	std::string source_str((std::istreambuf_iterator<char>(stream)),
-		std::istreambuf_iterator<char>());
-	source = source_str;
+	Lexer_Tables tables;
+
+	for (int c = 0; c < 256; c++)
+	{
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+		{
+			tables.classes[c] = CHAR_IDENTIFIER;
+		}
+		else if (c >= '0' && c <= '9')
+		{
+			tables.classes[c] = CHAR_DIGIT;
+		}
+	}
+
+	for (const Operator& op : OPERATORS)
+	{
+		Operator_Entry& entry = tables.operators[(unsigned char)op.text[0]];
+		tables.classes[(unsigned char)op.text[0]] = CHAR_OPERATOR;
+
+		if (op.text[1] == '\0')
+		{
+			entry.single = op.type;
+		}
+		else
+		{
+			entry.second[entry.pair_count] = op.text[1];
+			entry.pair[entry.pair_count] = op.type;
+			entry.pair_count++;
+		}
+	}
+
+	tables.classes['\n'] = CHAR_NEWLINE;
+	tables.classes[' '] = CHAR_SPACE;
+	tables.classes['\t'] = CHAR_SPACE;
+	tables.classes['"'] = CHAR_QUOTE;
+	tables.classes['/'] = CHAR_SLASH;
+
+	return tables;
+}
+
+static constexpr Lexer_Tables lexer_tables = build_lexer_tables();
+
+static bool is_identifier_char(char c)
+{
+	Char_Class char_class = lexer_tables.classes[(unsigned char)c];
+	return char_class == CHAR_IDENTIFIER || char_class == CHAR_DIGIT;
+}
+
+static bool is_space_char(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static bool is_line_char(char c)
+{
+	return c != '\n' && c != '\0';
+}
+
+static bool is_string_char(char c)
+{
+	return c != '"' && c != '\\' && c != '\n' && c != '\0';
+}
+
+static bool is_comment_char(char c)
+{
+	return c != '*' && c != '/' && c != '\n' && c != '\0';
+}
+
+// Length of the run matching 'match' at 'index'. Short runs, the common case, are scanned here;
+// the vector kernels only pay for their call once a run is longer than a block.
+template <bool (*match)(char)>
+static int run_length(std::string_view source, int index, size_t (*kernel)(const char*, size_t))
+{
+	const int INLINE_LENGTH = 16;
+
+	int end = index;
+	int limit = std::min((int)source.length(), index + INLINE_LENGTH);
+
+	while (end < limit && match(source[end]))
+	{
+		end++;
+	}
+
+	if (end == index + INLINE_LENGTH)
+	{
+		end += kernel(source.data() + end, source.length() - end);
+	}
+
+	return end - index;
 }
 
+// ########### LEXER ########### //
+
 void Lexer::error_and_exit(std::string message)
 {
-	std::string error_message = "\n\n[Lexer] Lexical Error in '" + file_name + "' @ (" + std::to_string(line) + ", " + std::to_string(column) + "): " + message;
+	Source_Location location = buffer->location(index);
+	std::string error_message = "\n\n[Lexer] Lexical Error in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	std::cout << error_message;
 	std::cout << "\nCompilation failed. Press any key to exit...";
 	std::cin.get();
@@ -19,14 +170,27 @@ void Lexer::error_and_exit(std::string message)
 
 void Lexer::error_and_continue(std::string message)
 {
-	std::string error_message = "[Lexer] Lexical Error in '" + file_name + "' @ (" + std::to_string(line) + ", " + std::to_string(column) + "): " + message;
+	Source_Location location = buffer->location(index);
+	std::string error_message = "[Lexer] Lexical Error in '" + file_name + "' @ (" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): " + message;
 	errors.push_back(error_message);
 }
 
 void Lexer::advance()
 {
 	index++;
-	column++;
+	if (index >= source_length)
+	{
+		current_char = '\0';
+	}
+	else
+	{
+		current_char = source[index];
+	}
+}
+
+void Lexer::skip(int count)
+{
+	index += count;
 	if (index >= source_length)
 	{
 		current_char = '\0';
@@ -50,48 +214,105 @@ char Lexer::peek()
 	}
 }
 
+// Keywords and boolean literals, recognised by length first so most identifiers are rejected
+// with a single comparison
+static Type keyword_type(std::string_view name)
+{
+	switch (name.length())
+	{
+	case 2:
+		if (name == "if")
+		{
+			return TYPE_KW_IF;
+		}
+		break;
+	case 3:
+		if (name == "def")
+		{
+			return TYPE_KW_DEF;
+		}
+		break;
+	case 4:
+		if (name == "else")
+		{
+			return TYPE_KW_ELSE;
+		}
+		if (name == "type")
+		{
+			return TYPE_KW_TYPE;
+		}
+		if (name == "true")
+		{
+			return TYPE_BOOL;
+		}
+		break;
+	case 5:
+		if (name == "while")
+		{
+			return TYPE_KW_WHILE;
+		}
+		if (name == "break")
+		{
+			return TYPE_KW_BREAK;
+		}
+		if (name == "false")
+		{
+			return TYPE_BOOL;
+		}
+		break;
+	case 6:
+		if (name == "return")
+		{
+			return TYPE_KW_RETURN;
+		}
+		break;
+	case 9:
+		if (name == "break_all")
+		{
+			return TYPE_KW_BREAK_ALL;
+		}
+		break;
+	}
+
+	return TYPE_ID;
+}
+
 void Lexer::build_identifier()
 {
-	auto token = std::make_shared<Token>(TYPE_ID, line, column);
+	Token token(TYPE_ID, index);
 
-	std::shared_ptr<std::string> name = std::make_shared<std::string>();
+	int start = index;
 
-	while (isalpha(current_char) || current_char == '_' || isdigit(current_char))
-	{
-		*name += current_char;
-		advance();
-	}
+	skip(run_length<is_identifier_char>(source, index, scanner->identifier_run));
+
+	std::string_view name = source.substr(start, index - start);
+
+	token.type = keyword_type(name);
 
-	if (*name == "true")
+	if (token.type == TYPE_BOOL)
 	{
-		token->type = TYPE_BOOL;
-		token->bool_value = true;
+		token.bool_value = name == "true";
+		tokens.push_back(token);
 	}
-
-	else if (*name == "false")
+	else if (token.type == TYPE_ID)
 	{
-		token->type = TYPE_BOOL;
-		token->bool_value = false;
+		tokens.push_back(token, name);
 	}
 	else
 	{
-		token->id_value = name;
+		tokens.push_back(token);
 	}
-
-	tokens.push_back(token);
 }
 
 void Lexer::build_number()
 {
-	auto token = std::make_shared<Token>(line, column);
+	Token token(index);
 
-	std::string value;
+	int start = index;
 	int num_dots = 0;
 
-	while (isdigit(current_char) || current_char == '.')
+	while (lexer_tables.classes[(unsigned char)current_char] == CHAR_DIGIT || current_char == '.')
 	{
-		value += current_char;
-
 		if (current_char == '.')
 		{
 			num_dots++;
@@ -100,102 +321,188 @@ void Lexer::build_number()
 		advance();
 	}
 
+	// Parsed in place, without a copy or the locale
+	const char* first = source.data() + start;
+	const char* last = source.data() + index;
+
 	if (num_dots == 0)
 	{
-		token->type = TYPE_INT;
-		token->int_value = std::stoi(value);
+		token.type = TYPE_INT;
+		if (std::from_chars(first, last, token.int_value).ec != std::errc())
+		{
+			token.type = TYPE_ERROR;
+			error_and_continue("Integer literal out of range.");
+		}
 	}
 	else if (num_dots == 1)
 	{
-		token->type = TYPE_FLOAT;
-		token->float_value = std::stof(value);
+		token.type = TYPE_FLOAT;
+		if (std::from_chars(first, last, token.float_value).ec != std::errc())
+		{
+			token.type = TYPE_ERROR;
+			error_and_continue("Float literal out of range.");
+		}
 	}
 	else
 	{
-		token->type = TYPE_ERROR;
+		token.type = TYPE_ERROR;
 		error_and_continue("Unacceptable number of dots in number token.");
 	}
 
 	tokens.push_back(token);
 }
 
-void Lexer::build_string()
+bool Lexer::decode_string(int& position, char* out, size_t& length)
 {
-	auto token = std::make_shared<Token>(TYPE_STRING, line, column);
-
-	std::shared_ptr<std::string> str = std::make_shared<std::string>();
+	length = 0;
 
-	advance();
+	// Set when the last byte kept was a backslash that may start an escape
+	bool escape = false;
 
-	while (current_char != '"')
+	auto keep = [&](char c)
 	{
-		if (current_char == '\0')
+		if (escape)
+		{
+			escape = false;
+
+			char control = c == 'n' ? '\n' : c == 'r' ? '\r' : c == 't' ? '\t' : '\0';
+			if (control)
+			{
+				if (out)
+				{
+					out[length] = control;
+				}
+				length++;
+				return;
+			}
+
+			if (out)
+			{
+				out[length] = '\\';
+			}
+			length++;
+		}
+
+		if (c == '\\')
 		{
-			error_and_continue("Warning: Missing end '\"', end of file reached.");
+			escape = true;
 			return;
 		}
 
-		if (current_char == '\n')
+		if (out)
 		{
-			line++;
-			column = 0;
-			advance(); // consume '\n'
+			out[length] = c;
 		}
+		length++;
+	};
 
-		*str += current_char;
-		advance();
-	}
+	while (true)
+	{
+		int run = run_length<is_string_char>(source, position, scanner->string_end);
 
-	advance();
+		if (run > 0)
+		{
+			// Only the first byte of a run can complete an escape
+			keep(source[position]);
+			if (out)
+			{
+				memcpy(out + length, source.data() + position + 1, run - 1);
+			}
+			length += run - 1;
+			position += run;
+		}
 
-	token->string_value = std::make_shared<std::string>();
+		char c = position < source_length ? source[position] : '\0';
 
-	for (int i = 0; i < (*str).length(); i++)
-	{
-		if ((*str)[i] == '\\' && (*str)[i + 1] == 'n')
+		if (c == '"')
 		{
-			(*str)[i] = '\n';
-			(*token->string_value).push_back('\n');
-			i++;
+			break;
 		}
-		else if ((*str)[i] == '\\' && (*str)[i + 1] == 'r')
+		else if (c == '\\')
 		{
-			(*str)[i] = '\r';
-			(*token->string_value).push_back('\r');
-			i++;
+			keep(c);
+			position++;
 		}
-		else if ((*str)[i] == '\\' && (*str)[i + 1] == 't')
+		else if (c == '\n' && position + 1 < source_length)
 		{
-			(*str)[i] = '\t';
-			(*token->string_value).push_back('\t');
-			i++;
+			// A line break is dropped and the byte after it is kept, whatever it is
+			keep(source[position + 1]);
+			position += 2;
 		}
 		else
 		{
-			(*token->string_value).push_back((*str)[i]);
+			position = std::min(position + (c == '\n' ? 1 : 0), source_length);
+			return false;
 		}
 	}
 
-	tokens.push_back(token);
+	if (escape)
+	{
+		if (out)
+		{
+			out[length] = '\\';
+		}
+		length++;
+	}
+
+	return true;
 }
 
-void Lexer::handle_line_comment()
+void Lexer::build_string()
 {
-	advance();
+	Token token(TYPE_STRING, index);
+
 	advance();
 
-	while (current_char != '\n')
-	{
-		if (current_char == '\0')
-		{
-			return;
-		}
+	// Literals without escapes or line breaks are used in place
+	int end = index + run_length<is_string_char>(source, index, scanner->string_end);
 
+	if (end < source_length && source[end] == '"')
+	{
+		std::string_view text = source.substr(index, end - index);
+		index = end;
+		current_char = source[index];
 		advance();
+		tokens.push_back(token, text);
+		return;
+	}
+
+	// Otherwise the literal is measured, then decoded straight into a buffer of its exact size
+	size_t length;
+	int close = index;
+
+	if (!decode_string(close, nullptr, length))
+	{
+		index = close;
+		current_char = '\0';
+		error_and_continue("Warning: Missing end '\"', end of file reached.");
+		return;
 	}
 
-	line++;
-	column = 0;
+	std::string& decoded = tokens.decode_buffer();
+	decoded.resize(length);
+
+	int position = index;
+	decode_string(position, decoded.data(), length);
+
+	index = close;
+	current_char = source[index];
+	advance();
+
+	tokens.push_back(token, decoded);
+}
+
+void Lexer::handle_line_comment()
+{
+	advance();
+	advance();
+
+	skip(run_length<is_line_char>(source, index, scanner->line_end));
+
+	if (current_char == '\0')
+	{
+		return;
+	}
 
 	advance(); // consume '\n'
 
@@ -207,12 +514,14 @@ void Lexer::handle_block_comment()
 	advance(); // consume '/'
 	advance(); // consume '*'
 
-	while (!(current_char == '*' && peek() == '/'))
+	while (true)
 	{
-		if (current_char == '\n')
+		// Nothing but '*', '/' and '\0' can end the comment
+		skip(run_length<is_comment_char>(source, index, scanner->comment_stop));
+
+		if (current_char == '*' && peek() == '/')
 		{
-			line++;
-			column = 0;
+			break;
 		}
 		if (current_char == '\0')
 		{
@@ -237,26 +546,54 @@ Lexer::Lexer(std::string src, bool is_file)
 {
 	if (is_file)
 	{
-		load_source(src);
+		buffer = Source_Buffer::from_file(src);
 		file_name = src;
 	}
 	else
 	{
-		source = src;
+		buffer = Source_Buffer::from_string(src);
 		file_name = "stdin";
 	}
 
+	source = buffer->view();
+	tokens.source = buffer;
 	source_length = source.length();
 	index = 0;
-	current_char = source[0];
-	line = 1;
-	column = 1;
+	current_char = source_length > 0 ? source[0] : '\0';
+}
+
+Lexer::Lexer(std::shared_ptr<Source_Buffer> buffer, std::string file_name, int begin, int end)
+	: file_name(file_name), buffer(buffer)
+{
+	source = buffer->view().substr(0, end);
+	tokens.source = buffer;
+	source_length = source.length();
+	quiet = true;
+	index = begin;
+	current_char = begin < source_length ? source[begin] : '\0';
+}
+
+Lexer::Lexer(const Lexer& parent, int start)
+{
+	file_name = parent.file_name;
+	buffer = parent.buffer;
+	source = parent.source;
+	tokens.source = buffer;
+	source_length = parent.source_length;
+	scanner = parent.scanner;
+	index = start;
+	current_char = start < source_length ? source[start] : '\0';
 }
 
 void Lexer::check_for_errors()
 {
 	if (errors.size() > 0)
 	{
+		has_errors = true;
+		if (quiet)
+		{
+			return;
+		}
 		std::cout << "[Lexer] Lexing unsuccessful - " + std::to_string(errors.size()) + " error(s) found.\n";
 		for (std::string error_message : errors)
 		{
@@ -275,355 +612,230 @@ std::string& Lexer::get_file_name()
 	return file_name;
 }
 
-std::vector<std::shared_ptr<Token>> Lexer::get_tokens()
+Token_Stream& Lexer::get_tokens()
 {
 	return tokens;
 }
 
-std::string& Lexer::get_source()
+std::string_view Lexer::get_source()
 {
 	return source;
 }
 
-void Lexer::tokenize()
+std::shared_ptr<Source_Buffer> Lexer::get_buffer()
 {
-	while (current_char != '\0')
+	return buffer;
+}
+
+void Lexer::build_operator()
+{
+	const Operator_Entry& entry = lexer_tables.operators[(unsigned char)current_char];
+	char next = peek();
+
+	for (int i = 0; i < entry.pair_count; i++)
 	{
-		if (current_char == '\n')
-		{
-			column = 0;
-			line++;
-			advance();
-		}
-		else if (current_char == ' ' || current_char == '\t')
+		if (entry.second[i] == next)
 		{
-			advance();
-		}
-		else if (isalpha(current_char) || current_char == '_')
-		{
-			build_identifier();
-		}
-		else if (isdigit(current_char))
-		{
-			build_number();
+			tokens.push_back(Token(entry.pair[i], index));
+			advance(); // consume first symbol
+			advance(); // consume second symbol
+			return;
 		}
-		else if (current_char == '/' && peek() == '/')
+	}
+
+	tokens.push_back(Token(entry.single, index));
+	advance(); // consume symbol
+}
+
+void Lexer::scan_next()
+{
+	if (current_char == '\0')
+	{
+		tokens.push_back(Token(TYPE_EOF, index));
+		finished = true;
+
+		check_for_errors();
+		return;
+	}
+
+	switch (lexer_tables.classes[(unsigned char)current_char])
+	{
+	case CHAR_NEWLINE:
+		advance();
+		break;
+	case CHAR_SPACE:
+		skip(run_length<is_space_char>(source, index, scanner->space_run));
+		break;
+	case CHAR_IDENTIFIER:
+		build_identifier();
+		break;
+	case CHAR_DIGIT:
+		build_number();
+		break;
+	case CHAR_QUOTE:
+		build_string();
+		break;
+	case CHAR_SLASH:
+		if (peek() == '/')
 		{
 			handle_line_comment();
 		}
-		else if (current_char == '/' && peek() == '*')
+		else if (peek() == '*')
 		{
 			handle_block_comment();
 		}
-		else if (current_char == '"')
-		{
-			build_string();
-		}
-		else if (current_char == '=' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_EQ_EQ, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume =
-			advance(); // consume =
-		}
-		else if (current_char == '!' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_NOT_EQUAL, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume !
-			advance(); // consume =
-		}
-		else if (current_char == '<' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_LT_EQUAL, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume <
-			advance(); // consume =
-		}
-		else if (current_char == '>' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_GT_EQUAL, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume >
-			advance(); // consume =
-		}
-		else if (current_char == '+' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_PLUS_EQ, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume +
-			advance(); // consume =
-		}
-		else if (current_char == '-' && peek() == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_MINUS_EQ, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume -
-			advance(); // consume =
-		}
-		else if (current_char == '+' && peek() == '+')
-		{
-			auto token = std::make_shared<Token>(TYPE_PLUS_PLUS, line, column);
-			token->is_post_op = true;
-			tokens.push_back(token);
-			advance(); // consume +
-			advance(); // consume +
-		}
-		else if (current_char == '-' && peek() == '-')
-		{
-			auto token = std::make_shared<Token>(TYPE_MINUS_MINUS, line, column);
-			token->is_post_op = true;
-			tokens.push_back(token);
-			advance(); // consume -
-			advance(); // consume -
-		}
-		else if (current_char == ':' && peek() == ':')
-		{
-			auto token = std::make_shared<Token>(TYPE_DOUBLE_COLON, line, column);
-			tokens.push_back(token);
-			advance(); // consume :
-			advance(); // consume :
-		}
-		else if (current_char == '=' && peek() == '>')
-		{
-			auto token = std::make_shared<Token>(TYPE_RIGHT_ARROW, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume =
-			advance(); // consume >
-		}
-		else if (current_char == '-' && peek() == '>')
-		{
-			auto token = std::make_shared<Token>(TYPE_RIGHT_ARROW_SINGLE, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume -
-			advance(); // consume >
-		}
-		else if (current_char == '&' && peek() == '&')
-		{
-			auto token = std::make_shared<Token>(TYPE_AND, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume &
-			advance(); // consume &
-		}
-		else if (current_char == '|' && peek() == '|')
-		{
-			auto token = std::make_shared<Token>(TYPE_OR, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume |
-			advance(); // consume |
-		}
-		else if (current_char == '=' && peek() == '&')
-		{
-			auto token = std::make_shared<Token>(TYPE_EQ_AND, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume =
-			advance(); // consume &
-		}
-		else if (current_char == '=')
-		{
-			auto token = std::make_shared<Token>(TYPE_EQUAL, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '(')
-		{
-			auto token = std::make_shared<Token>(TYPE_LPAREN, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == ')')
-		{
-			auto token = std::make_shared<Token>(TYPE_RPAREN, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '{')
-		{
-			auto token = std::make_shared<Token>(TYPE_LBRACE, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '}')
-		{
-			auto token = std::make_shared<Token>(TYPE_RBRACE, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '[')
-		{
-			auto token = std::make_shared<Token>(TYPE_LBRACKET, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == ']')
-		{
-			auto token = std::make_shared<Token>(TYPE_RBRACKET, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '<')
-		{
-			auto token = std::make_shared<Token>(TYPE_LANGLE, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '>')
-		{
-			auto token = std::make_shared<Token>(TYPE_RANGLE, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '.')
-		{
-			auto token = std::make_shared<Token>(TYPE_DOT, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '\\')
-		{
-			auto token = std::make_shared<Token>(TYPE_BACKSLASH, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '\'')
-		{
-			auto token = std::make_shared<Token>(TYPE_APOSTROPHE, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '!')
-		{
-			auto token = std::make_shared<Token>(TYPE_EXCLAMATION, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '@')
-		{
-			auto token = std::make_shared<Token>(TYPE_AT, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '#')
-		{
-			auto token = std::make_shared<Token>(TYPE_HASH, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '$')
-		{
-			auto token = std::make_shared<Token>(TYPE_DOLLAR, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '^')
-		{
-			auto token = std::make_shared<Token>(TYPE_CARET, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '&')
-		{
-			auto token = std::make_shared<Token>(TYPE_B_AND, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '|')
-		{
-			auto token = std::make_shared<Token>(TYPE_B_OR, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '?')
-		{
-			auto token = std::make_shared<Token>(TYPE_QUESTION, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '%')
-		{
-			auto token = std::make_shared<Token>(TYPE_PERCENT, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '"')
-		{
-			auto token = std::make_shared<Token>(TYPE_DOUBLE_QUOTE, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '-')
-		{
-			auto token = std::make_shared<Token>(TYPE_MINUS, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
-		}
-		else if (current_char == '+')
+		else
 		{
-			auto token = std::make_shared<Token>(TYPE_PLUS, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
+			build_operator();
 		}
-		else if (current_char == '/')
+		break;
+	case CHAR_OPERATOR:
+		build_operator();
+		break;
+	default:
+		error_and_continue("Unexpected token '" + std::string(1, current_char) + "'.");
+		tokens.push_back(Token(TYPE_ERROR, index));
+		advance();
+		break;
+	}
+}
+
+Token& Lexer::next_token()
+{
+	size_t next = tokens.size();
+
+	while (tokens.size() == next && !finished)
+	{
+		scan_next();
+	}
+
+	return tokens[std::min(next, tokens.size() - 1)];
+}
+
+void Lexer::tokenize()
+{
+	// Typical sources average a token every few bytes; reserving avoids regrowing the array
+	tokens.tokens.reserve(source_length / 4 + 1);
+
+	while (!finished)
+	{
+		scan_next();
+	}
+}
+void Lexer::scan_chunk(int end, const std::vector<int>& starts)
+{
+	while (current_char != '\0')
+	{
+		if (index >= end && (index == end || std::binary_search(starts.begin(), starts.end(), index)))
 		{
-			auto token = std::make_shared<Token>(TYPE_SLASH, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
+			return;
 		}
-		else if (current_char == '*')
+
+		scan_next();
+	}
+}
+
+void Lexer::tokenize_parallel(unsigned threads, size_t chunk_size)
+{
+	// Chunks start just after a newline. Unless a string or block comment spans that newline,
+	// the sequential lexer is between tokens there.
+	std::vector<int> starts = { 0 };
+
+	while (true)
+	{
+		size_t newline = source.find('\n', starts.back() + std::max<size_t>(chunk_size, 1) - 1);
+		if (newline == std::string_view::npos || newline + 1 >= (size_t)source_length)
 		{
-			auto token = std::make_shared<Token>(TYPE_STAR, line, column);
-			token->is_op = true;
-			tokens.push_back(token);
-			advance(); // consume symbol
+			break;
 		}
-		else if (current_char == ',')
+		starts.push_back(newline + 1);
+	}
+
+	if (threads <= 1 || starts.size() == 1 || tokens.size() != 0 || tokens.window)
+	{
+		tokenize();
+		return;
+	}
+
+	std::vector<std::unique_ptr<Lexer>> chunks;
+	for (int start : starts)
+	{
+		chunks.emplace_back(new Lexer(*this, start));
+	}
+
+	std::atomic<size_t> next_chunk(0);
+
+	auto work = [&]()
+	{
+		for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++)
 		{
-			auto token = std::make_shared<Token>(TYPE_COMMA, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
+			int end = i + 1 < starts.size() ? starts[i + 1] : source_length;
+			chunks[i]->scan_chunk(end, starts);
 		}
-		else if (current_char == ':')
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < std::min<size_t>(threads, chunks.size()); i++)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	// Each chunk stops at the start of the next chunk the sequential lexer would reach between
+	// tokens. Following those links skips chunks that began inside a string or comment. Token
+	// offsets are already positions in the whole source.
+	std::vector<size_t> used;
+	size_t total = 0;
+
+	for (size_t i = 0; ; )
+	{
+		Lexer& chunk = *chunks[i];
+
+		// Let the sequential lexer report errors exactly as it always has
+		if (!chunk.errors.empty())
 		{
-			auto token = std::make_shared<Token>(TYPE_COLON, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
+			tokenize();
+			return;
 		}
-		else if (current_char == ';')
+
+		used.push_back(i);
+		total += chunk.tokens.size();
+
+		if (chunk.current_char == '\0')
 		{
-			auto token = std::make_shared<Token>(TYPE_SEMICOLON, line, column);
-			tokens.push_back(token);
-			advance(); // consume symbol
+			break;
 		}
-		else
+
+		i = std::lower_bound(starts.begin() + i + 1, starts.end(), chunk.index) - starts.begin();
+	}
+
+	tokens.tokens.reserve(total + 1);
+
+	for (size_t i : used)
+	{
+		Lexer& chunk = *chunks[i];
+		uint32_t text_base = tokens.texts.size();
+
+		for (Token token : chunk.tokens.tokens)
 		{
-			error_and_continue("Unexpected token '" + std::string(1, current_char) + "'.");
-			auto token = std::make_shared<Token>(TYPE_ERROR, line, column);
+			if (token.type == TYPE_ID || token.type == TYPE_STRING)
+			{
+				token.text += text_base;
+			}
 			tokens.push_back(token);
-			advance();
 		}
-	}
 
-	auto token = std::make_shared<Token>(TYPE_EOF, line, column);
-	tokens.push_back(token);
+		// Decoded strings keep their addresses when spliced, so the views stay valid
+		tokens.texts.insert(tokens.texts.end(), chunk.tokens.texts.begin(), chunk.tokens.texts.end());
+		tokens.decoded.splice(tokens.decoded.end(), chunk.tokens.decoded);
 
-	check_for_errors();
-}
\ No newline at end of file
+		index = chunk.index;
+	}
+
+	current_char = '\0';
+	scan_next();
+}
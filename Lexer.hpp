@@ -5,23 +5,26 @@
 #include <streambuf>
 #include <map>
 #include <iostream>
+#include <memory>
 
 #include "Type.hpp"
 #include "Token.hpp"
+#include "Source.hpp"
+#include "Scanner.hpp"
 
 class Lexer
 {
 	std::string file_name;
-	std::string source;
+	std::shared_ptr<Source_Buffer> buffer;
+	std::string_view source;
 	int source_length;
 	int index = 0;
 	char current_char;
-	int line = 1;
-	int column = 1;
 	std::vector<std::string> errors;
 	bool debug = false;
 
-	void load_source(std::string filename);
+	// Lexers over part of a source leave reporting errors to the lexer over all of it
+	bool quiet = false;
 
 	void error_and_exit(std::string message);
 
@@ -29,31 +32,76 @@ class Lexer
 
 	void advance();
 
+	void skip(int count);
+
 	char peek();
 
 	void build_identifier();
 
 	void build_number();
 
+	// Walks a string literal's body from 'position' to its closing quote, decoding \n, \r and
+	// \t, and leaves 'position' on the quote. Writes to 'out' unless it's null; 'length' is
+	// the decoded length either way. Returns false, with 'position' where the source ends,
+	// for an unterminated literal.
+	bool decode_string(int& position, char* out, size_t& length);
+
 	void build_string();
 
+	void build_operator();
+
+	// Adds at most one token, or the EOF token once the source is exhausted
+	void scan_next();
+
 	void handle_line_comment();
 
 	void handle_block_comment();
 
+	// Lexer for one chunk of a parallel tokenize, starting at 'start' in 'parent's source
+	Lexer(const Lexer& parent, int start);
+
+	// Lexes up to 'end', then on until it stops between tokens at one of the chunk 'starts' or
+	// at the end of the source. Adds no EOF token.
+	void scan_chunk(int end, const std::vector<int>& starts);
+
 public:
 
-	std::vector<std::shared_ptr<Token>> tokens;
+	Token_Stream tokens;
+	bool has_errors = false;
+	bool finished = false;
+
+	const Scan_Kernels* scanner = &default_scan_kernels();
 
 	Lexer(std::string src, bool is_file = true);
 
+	// Lexes only [begin, end) of 'buffer', without reporting errors. Token offsets are still
+	// positions in the whole buffer.
+	Lexer(std::shared_ptr<Source_Buffer> buffer, std::string file_name, int begin, int end);
+
 	void check_for_errors();
 
 	std::string& get_file_name();
 
-	std::vector<std::shared_ptr<Token>> get_tokens();
+	Token_Stream& get_tokens();
+
+	std::string_view get_source();
 
-	std::string& get_source();
+	// Lexes and returns the next token, for parsers that pull tokens on demand. Returns EOF
+	// again once the source is exhausted.
+	Token& next_token();
+
+	// Tokens point into this buffer, so it must outlive them
+	std::shared_ptr<Source_Buffer> get_buffer();
 
 	void tokenize();
+
+	// Sources at least this big are lexed in parallel by parse_cached, in chunks of about
+	// PARALLEL_CHUNK bytes
+	static const size_t PARALLEL_THRESHOLD = 8 << 20;
+	static const size_t PARALLEL_CHUNK = 1 << 20;
+
+	// Lexes chunks of at least 'chunk_size' bytes, split after newlines, on 'threads' threads
+	// and joins them into the same tokens tokenize() produces. Falls back to tokenize() when
+	// a chunk in use has errors.
+	void tokenize_parallel(unsigned threads, size_t chunk_size);
 };
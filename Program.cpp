@@ -1,7 +1,99 @@
 #include "Tests.hpp"
 
-int main()
+int main(int argc, char** argv)
 {
 	//ast_node_test();
-	ast_parser_test();
+
+	if (argc > 1 && std::string(argv[1]) == "--vm")
+	{
+		vm_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-scope")
+	{
+		scope_lookup_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-modules")
+	{
+		module_cache_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-ast-cache")
+	{
+		ast_cache_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-ast-cache")
+	{
+		ast_cache_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-ast-memory")
+	{
+		ast_memory_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-lazy-parse")
+	{
+		lazy_parse_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-binary-ops")
+	{
+		binary_op_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-calls")
+	{
+		call_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--bench-lexer")
+	{
+		lexer_benchmark();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-lexer-scan")
+	{
+		lexer_scan_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-lexer-parallel")
+	{
+		lexer_parallel_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-locations")
+	{
+		source_location_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-lexer-strings")
+	{
+		lexer_string_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-lexer-numbers")
+	{
+		lexer_number_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-precedence")
+	{
+		parser_precedence_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-quickening")
+	{
+		quickening_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-values")
+	{
+		value_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-types")
+	{
+		type_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-vm")
+	{
+		vm_test_programs();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-lazy-errors")
+	{
+		lazy_body_error_test();
+	}
+	else if (argc > 1 && std::string(argv[1]) == "--test-payloads")
+	{
+		payload_test();
+	}
+	else
+	{
+		ast_parser_test();
+	}
 }
\ No newline at end of file
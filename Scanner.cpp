@@ -0,0 +1,350 @@
+#include "Scanner.hpp"
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SCANNER_X86
+#endif
+
+#if defined(SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SCANNER_AVX2
+#define SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// ########### SCALAR ########### //
+
+static bool is_identifier_byte(unsigned char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static size_t scalar_identifier_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && is_identifier_byte(data[i]))
+	{
+		i++;
+	}
+	return i;
+}
+
+static size_t scalar_space_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && (data[i] == ' ' || data[i] == '\t'))
+	{
+		i++;
+	}
+	return i;
+}
+
+static size_t scalar_line_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && data[i] != '\n' && data[i] != '\0')
+	{
+		i++;
+	}
+	return i;
+}
+
+static size_t scalar_string_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && data[i] != '"' && data[i] != '\\' && data[i] != '\n' && data[i] != '\0')
+	{
+		i++;
+	}
+	return i;
+}
+
+static size_t scalar_comment_stop(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && data[i] != '*' && data[i] != '/' && data[i] != '\n' && data[i] != '\0')
+	{
+		i++;
+	}
+	return i;
+}
+
+static int first_bit(unsigned int mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(mask);
+#else
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#endif
+}
+
+// ########### SSE2 ########### //
+
+#ifdef SCANNER_X86
+
+// Bytes in [lo, hi]: shift the range down to start at -128 so one signed compare tests both ends
+static __m128i sse2_in_range(__m128i bytes, char lo, char hi)
+{
+	__m128i shifted = _mm_add_epi8(bytes, _mm_set1_epi8((char)(0x80 - lo)));
+	return _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(0x80 + (hi - lo) + 1)));
+}
+
+static __m128i sse2_equals(__m128i bytes, char c)
+{
+	return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+}
+
+static size_t sse2_identifier_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+		__m128i match = _mm_or_si128(_mm_or_si128(sse2_in_range(lower, 'a', 'z'), sse2_in_range(bytes, '0', '9')), sse2_equals(bytes, '_'));
+		unsigned int stop = ~_mm_movemask_epi8(match) & 0xFFFF;
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + scalar_identifier_run(data + i, size - i);
+}
+
+static size_t sse2_space_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i match = _mm_or_si128(sse2_equals(bytes, ' '), sse2_equals(bytes, '\t'));
+		unsigned int stop = ~_mm_movemask_epi8(match) & 0xFFFF;
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + scalar_space_run(data + i, size - i);
+}
+
+static size_t sse2_line_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i match = _mm_or_si128(sse2_equals(bytes, '\n'), sse2_equals(bytes, '\0'));
+		unsigned int stop = _mm_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + scalar_line_end(data + i, size - i);
+}
+
+static size_t sse2_string_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i match = _mm_or_si128(_mm_or_si128(sse2_equals(bytes, '"'), sse2_equals(bytes, '\\')),
+			_mm_or_si128(sse2_equals(bytes, '\n'), sse2_equals(bytes, '\0')));
+		unsigned int stop = _mm_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + scalar_string_end(data + i, size - i);
+}
+
+static size_t sse2_comment_stop(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i match = _mm_or_si128(_mm_or_si128(sse2_equals(bytes, '*'), sse2_equals(bytes, '/')),
+			_mm_or_si128(sse2_equals(bytes, '\n'), sse2_equals(bytes, '\0')));
+		unsigned int stop = _mm_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + scalar_comment_stop(data + i, size - i);
+}
+
+#endif
+
+// ########### AVX2 ########### //
+
+#ifdef SCANNER_AVX2
+
+SCANNER_TARGET_AVX2 static __m256i avx2_in_range(__m256i bytes, char lo, char hi)
+{
+	__m256i shifted = _mm256_add_epi8(bytes, _mm256_set1_epi8((char)(0x80 - lo)));
+	return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + (hi - lo) + 1)), shifted);
+}
+
+SCANNER_TARGET_AVX2 static __m256i avx2_equals(__m256i bytes, char c)
+{
+	return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c));
+}
+
+SCANNER_TARGET_AVX2 static size_t avx2_identifier_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+		__m256i match = _mm256_or_si256(_mm256_or_si256(avx2_in_range(lower, 'a', 'z'), avx2_in_range(bytes, '0', '9')), avx2_equals(bytes, '_'));
+		unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + sse2_identifier_run(data + i, size - i);
+}
+
+SCANNER_TARGET_AVX2 static size_t avx2_space_run(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i match = _mm256_or_si256(avx2_equals(bytes, ' '), avx2_equals(bytes, '\t'));
+		unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + sse2_space_run(data + i, size - i);
+}
+
+SCANNER_TARGET_AVX2 static size_t avx2_line_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i match = _mm256_or_si256(avx2_equals(bytes, '\n'), avx2_equals(bytes, '\0'));
+		unsigned int stop = (unsigned int)_mm256_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + sse2_line_end(data + i, size - i);
+}
+
+SCANNER_TARGET_AVX2 static size_t avx2_string_end(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i match = _mm256_or_si256(_mm256_or_si256(avx2_equals(bytes, '"'), avx2_equals(bytes, '\\')),
+			_mm256_or_si256(avx2_equals(bytes, '\n'), avx2_equals(bytes, '\0')));
+		unsigned int stop = (unsigned int)_mm256_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + sse2_string_end(data + i, size - i);
+}
+
+SCANNER_TARGET_AVX2 static size_t avx2_comment_stop(const char* data, size_t size)
+{
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i match = _mm256_or_si256(_mm256_or_si256(avx2_equals(bytes, '*'), avx2_equals(bytes, '/')),
+			_mm256_or_si256(avx2_equals(bytes, '\n'), avx2_equals(bytes, '\0')));
+		unsigned int stop = (unsigned int)_mm256_movemask_epi8(match);
+		if (stop)
+		{
+			return i + first_bit(stop);
+		}
+	}
+	return i + sse2_comment_stop(data + i, size - i);
+}
+
+#endif
+
+// ########### DISPATCH ########### //
+
+static const Scan_Kernels scalar_kernels =
+{
+	SCAN_SCALAR, scalar_identifier_run, scalar_space_run, scalar_line_end, scalar_string_end, scalar_comment_stop
+};
+
+#ifdef SCANNER_X86
+static const Scan_Kernels sse2_kernels =
+{
+	SCAN_SSE2, sse2_identifier_run, sse2_space_run, sse2_line_end, sse2_string_end, sse2_comment_stop
+};
+#endif
+
+#ifdef SCANNER_AVX2
+static const Scan_Kernels avx2_kernels =
+{
+	SCAN_AVX2, avx2_identifier_run, avx2_space_run, avx2_line_end, avx2_string_end, avx2_comment_stop
+};
+#endif
+
+const Scan_Kernels* get_scan_kernels(Scan_Mode mode)
+{
+	switch (mode)
+	{
+	case SCAN_SCALAR:
+		return &scalar_kernels;
+#ifdef SCANNER_X86
+	case SCAN_SSE2:
+		// Part of the x86-64 baseline
+		return &sse2_kernels;
+#endif
+#ifdef SCANNER_AVX2
+	case SCAN_AVX2:
+		return __builtin_cpu_supports("avx2") ? &avx2_kernels : nullptr;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+const Scan_Kernels& default_scan_kernels()
+{
+	static const Scan_Kernels* kernels = []()
+	{
+		for (Scan_Mode mode : { SCAN_AVX2, SCAN_SSE2 })
+		{
+			if (const Scan_Kernels* supported = get_scan_kernels(mode))
+			{
+				return supported;
+			}
+		}
+		return &scalar_kernels;
+	}();
+
+	return *kernels;
+}
+
+const char* scan_mode_name(Scan_Mode mode)
+{
+	switch (mode)
+	{
+	case SCAN_SCALAR:	return "scalar";
+	case SCAN_SSE2:		return "sse2";
+	case SCAN_AVX2:		return "avx2";
+	default:			return "unknown";
+	}
+}
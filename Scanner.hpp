@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+// Byte-run kernels used by the Lexer to skip over whitespace, identifiers, comment bodies and
+// string bodies. Each kernel looks at 'size' bytes from 'data' and returns how many bytes it
+// can skip. The vector versions handle 16 or 32 bytes per step and finish with the scalar loop.
+enum Scan_Mode
+{
+	SCAN_SCALAR,
+	SCAN_SSE2,
+	SCAN_AVX2,
+};
+
+struct Scan_Kernels
+{
+	Scan_Mode mode;
+
+	// Length of the run of [A-Za-z0-9_]
+	size_t (*identifier_run)(const char* data, size_t size);
+
+	// Length of the run of ' ' and '\t'
+	size_t (*space_run)(const char* data, size_t size);
+
+	// Distance to the first '\n' or '\0'
+	size_t (*line_end)(const char* data, size_t size);
+
+	// Distance to the first '"', '\\', '\n' or '\0'
+	size_t (*string_end)(const char* data, size_t size);
+
+	// Distance to the first '*', '/', '\n' or '\0'
+	size_t (*comment_stop)(const char* data, size_t size);
+};
+
+// The fastest kernels this CPU supports, detected on first use
+const Scan_Kernels& default_scan_kernels();
+
+// Returns nullptr if 'mode' isn't available in this build or on this CPU
+const Scan_Kernels* get_scan_kernels(Scan_Mode mode);
+
+const char* scan_mode_name(Scan_Mode mode);
@@ -0,0 +1,86 @@
+#include "Source.hpp"
+#include "Scanner.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_USE_MMAP
+#endif
+
+Source_Buffer::~Source_Buffer()
+{
+#ifdef SOURCE_USE_MMAP
+	if (mapped)
+	{
+		munmap((void*)data, size);
+	}
+#endif
+}
+
+std::shared_ptr<Source_Buffer> Source_Buffer::from_file(const std::string& file_name)
+{
+#ifdef SOURCE_USE_MMAP
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat info;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+		{
+			void* memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (memory != MAP_FAILED)
+			{
+				close(fd);
+				auto buffer = std::make_shared<Source_Buffer>();
+				buffer->data = (const char*)memory;
+				buffer->size = info.st_size;
+				buffer->mapped = true;
+				return buffer;
+			}
+		}
+		close(fd);
+	}
+#endif
+
+	// Empty files, pipes and platforms without mmap are read into memory
+	std::ifstream stream(file_name);
+	std::string text((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	return from_string(std::move(text));
+}
+
+std::shared_ptr<Source_Buffer> Source_Buffer::from_string(std::string text)
+{
+	auto buffer = std::make_shared<Source_Buffer>();
+	buffer->owned = std::move(text);
+	buffer->data = buffer->owned.data();
+	buffer->size = buffer->owned.size();
+	return buffer;
+}
+
+Source_Location Source_Buffer::location(uint32_t offset)
+{
+	// Lexer threads can report errors at the same time, so the table is built exactly once
+	std::call_once(line_starts_built, [this]()
+	{
+		auto line_end = default_scan_kernels().line_end;
+
+		line_starts.push_back(0);
+		for (size_t i = 0; i < size; i++)
+		{
+			i += line_end(data + i, size - i);
+			if (i < size && data[i] == '\n')
+			{
+				line_starts.push_back(i + 1);
+			}
+		}
+	});
+
+	offset = std::min<size_t>(offset, size);
+	auto line = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - 1;
+
+	return { int(line - line_starts.begin()) + 1, int(offset - *line) + 1 };
+}
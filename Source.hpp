@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Line and column of a byte, both counted from 1. Columns count bytes.
+struct Source_Location
+{
+	int line = 1;
+	int column = 1;
+};
+
+// Read-only view of a source file. Files are memory mapped where the platform allows it, so
+// tokens can point straight into the buffer instead of copying their text out of it.
+class Source_Buffer
+{
+	const char* data = nullptr;
+	size_t size = 0;
+	std::string owned;
+	bool mapped = false;
+
+	// Offset of the first byte of each line, built on the first location() call
+	std::vector<uint32_t> line_starts;
+	std::once_flag line_starts_built;
+
+public:
+
+	Source_Buffer() = default;
+	Source_Buffer(const Source_Buffer&) = delete;
+	Source_Buffer& operator=(const Source_Buffer&) = delete;
+	~Source_Buffer();
+
+	static std::shared_ptr<Source_Buffer> from_file(const std::string& file_name);
+
+	static std::shared_ptr<Source_Buffer> from_string(std::string text);
+
+	std::string_view view() const { return std::string_view(data, size); }
+
+	// Tokens and nodes only keep byte offsets; lines and columns are worked out when reporting
+	// an error. Offsets past the end are clamped to it.
+	Source_Location location(uint32_t offset);
+};
@@ -0,0 +1,20 @@
+#include "Symbol.hpp"
+
+static std::unordered_map<std::string, int>& symbols()
+{
+	static std::unordered_map<std::string, int> table;
+	return table;
+}
+
+int intern(const std::string& name)
+{
+	auto& table = symbols();
+	return table.emplace(name, (int)table.size()).first->second;
+}
+
+int find_symbol(const std::string& name)
+{
+	auto& table = symbols();
+	auto symbol = table.find(name);
+	return symbol == table.end() ? -1 : symbol->second;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+// Names are interned once into small integer ids, so scope indexes hash and compare ints
+// instead of strings.
+int intern(const std::string& name);
+
+// Returns -1 if 'name' was never interned, i.e. no scope can contain it
+int find_symbol(const std::string& name);
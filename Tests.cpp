@@ -1,21 +1,23 @@
 #include "Tests.hpp"
+#include <cmath>
+#include <sstream>
 
 void ast_node_test()
 {
 	//std::shared_ptr<AST_Node> scope = std::make_shared<AST_Node>(TYPE_SCOPE);
-	//scope->SCOPE.name = "global";
+	//scope->SCOPE().name = "global";
 	//
 	//auto var_value = std::make_shared<AST_Node>(TYPE_EMPTY);
 	//var_value->FLOAT.value = 45.56;
 
 	//auto var = create_var("x", var_value);
 
-	//scope->SCOPE.data.push_back(var);
+	//scope->SCOPE().data.push_back(var);
 
 	//std::shared_ptr<AST_Node> f = std::make_shared<AST_Node>(TYPE_FLOAT);
 	//f->FLOAT.value = 46.74;
 
-	//int cast = implicit_cast(var->VAR.value, "custom");
+	//int cast = implicit_cast(var->VAR().value, "custom");
 
 	//auto v = get_var_in_scope("x", scope);
 	//auto v2 = create_ref(v);
@@ -30,14 +32,15 @@ void ast_node_test()
 void ast_parser_test()
 {
 	Lexer lexer("source.txt");
-	lexer.tokenize();
+	AST_Parser parser = parse_cached(lexer);
 
-	AST_Parser parser(lexer);
-	parser.parse();
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
 
 	AST_Eval eval(parser);
 
 	eval.init();
+	eval.global_scope->SCOPE().slots.resize(globals);
 
 	if (parser.expressions.size() == 0)
 	{
@@ -47,8 +50,8 @@ void ast_parser_test()
 
 	for (auto expr : parser.expressions)
 	{
-		eval.eval(expr);
-		if (expr->type == TYPE_ERROR)
+		auto result = eval.eval(expr);
+		if (result->type == TYPE_ERROR)
 		{
 			std::cout << "\nRunTimeError: Program Exited...";
 			std::cin.get();
@@ -57,4 +60,1402 @@ void ast_parser_test()
 	}
 
 	std::cin.get();
-}
\ No newline at end of file
+}
+
+void vm_test()
+{
+	Lexer lexer("source.txt");
+	AST_Parser parser = parse_cached(lexer);
+
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
+
+	VM vm(parser);
+
+	vm.init();
+	vm.eval.global_scope->SCOPE().slots.resize(globals);
+
+	if (parser.expressions.size() == 0)
+	{
+		std::cin.get();
+		return;
+	}
+
+	AST_Compiler compiler;
+	auto chunk = compiler.compile(parser.expressions);
+
+	if (!vm.run(chunk))
+	{
+		std::cout << "\nRunTimeError: Program Exited...";
+		std::cin.get();
+		exit(1);
+	}
+
+	std::cin.get();
+}
+
+void scope_lookup_benchmark()
+{
+	const int lookups = 1000000;
+
+	for (int size : { 10, 100, 1000, 10000, 100000 })
+	{
+		AST_Eval eval;
+		eval.init();
+
+		// A named scope of 'size' fields inside the global scope, like 'Person::field'
+		auto scope = eval.new_scope("Person");
+		std::vector<std::string> names;
+		for (int i = 0; i < size; i++)
+		{
+			names.push_back("field_" + std::to_string(i));
+			eval.add_data_to_scope(eval.create_var(names.back(), std::make_shared<AST_Node>(TYPE_INT)), scope);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		int found = 0;
+		for (int i = 0; i < lookups; i++)
+		{
+			found += eval.get_data_from_scope(names[((size_t)i * 7919) % size], scope) != nullptr;
+		}
+
+		// Unqualified lookups from the enclosing scope miss 'Person' and fall through to global
+		eval.enter_scope(scope);
+		for (int i = 0; i < lookups; i++)
+		{
+			found += eval.get_data("Person") != nullptr;
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count() / (2.0 * lookups);
+
+		std::cout << "scope size " << size << ": " << ns << " ns/lookup (" << found << " found)\n";
+	}
+}
+
+// Runs 'source' and returns what it printed, along with the values of the globals 'names'
+static std::string run_with_globals(const std::string& source, const std::vector<std::string>& names, std::vector<std::shared_ptr<AST_Node>>& values)
+{
+	std::ostringstream output;
+	std::streambuf* out = std::cout.rdbuf(output.rdbuf());
+
+	Lexer lexer(source, false);
+	AST_Parser parser(lexer);
+	parser.parse();
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
+
+	AST_Eval eval(parser);
+	eval.init();
+	eval.global_scope->SCOPE().slots.resize(globals);
+	for (auto& expr : parser.expressions)
+	{
+		eval.eval(expr);
+	}
+
+	for (auto& name : names)
+	{
+		auto var = eval.get_data(name);
+		values.push_back(var ? var->VAR().get() : nullptr);
+	}
+
+	std::cout.rdbuf(out);
+	return output.str();
+}
+
+void module_cache_test()
+{
+	const std::string module_name = "module_cache_test.txt";
+	{
+		std::ofstream stream(module_name);
+		stream << "value = 1; name = \"module\";\n";
+	}
+
+	Module_Cache& cache = module_cache();
+	int hits = cache.hits;
+	int misses = cache.misses;
+	int failures = 0;
+
+	// Both importers get the one evaluated module, so a write through one shows up in the other
+	std::vector<std::shared_ptr<AST_Node>> first;
+	std::string output = run_with_globals("a = import(\"" + module_name + "\"); b = import(\"" + module_name + "\"); a::value = 5; print(b::value);",
+		{ "a", "b" }, first);
+
+	std::cout << "two imports: " << cache.hits - hits << " hit(s), " << cache.misses - misses << " miss(es), printed " << output << "\n";
+	if (cache.hits - hits != 1 || cache.misses - misses != 1 || !first[0] || first[0] != first[1] || output != "5")
+	{
+		std::cout << "failed: the imports didn't share one module\n";
+		failures++;
+	}
+
+	// A newer modification time makes the next import evaluate the file again
+	std::filesystem::last_write_time(module_name, std::filesystem::last_write_time(module_name) + std::chrono::seconds(1));
+
+	std::vector<std::shared_ptr<AST_Node>> second;
+	output = run_with_globals("c = import(\"" + module_name + "\"); print(c::value);", { "c" }, second);
+
+	std::cout << "after touching the file: " << cache.hits - hits << " hit(s), " << cache.misses - misses << " miss(es), printed " << output << "\n";
+	if (cache.hits - hits != 1 || cache.misses - misses != 2 || !second[0] || second[0] == first[0] || output != "1")
+	{
+		std::cout << "failed: the touched file was served from the cache\n";
+		failures++;
+	}
+
+	std::remove(module_name.c_str());
+	std::remove((module_name + ".astc").c_str());
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void ast_cache_benchmark()
+{
+	const std::string file_name = "ast_cache_bench.txt";
+	const int functions = 20000;
+
+	{
+		std::ofstream stream(file_name);
+		for (int i = 0; i < functions; i++)
+		{
+			stream << "def f" << i << "(a, b) { c = a * " << i << " + b / 2.5; if (c == 0) { return \"zero\"; } "
+				<< "while (c != 0) { c = c - 1; } return c; }\n";
+			stream << "S" << i << " { x = f" << i << "(" << i << ", 3); y = \"item " << i << "\"; };\n";
+		}
+	}
+
+	std::remove((file_name + ".astc").c_str());
+
+	auto time_parse = [&file_name](size_t& count)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		Lexer lexer(file_name);
+		AST_Parser parser = parse_cached(lexer);
+		auto end = std::chrono::high_resolution_clock::now();
+		count = parser.expressions.size();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	};
+
+	size_t cold_count = 0, warm_count = 0;
+	double cold = time_parse(cold_count);
+	double warm = time_parse(warm_count);
+
+	std::ifstream source(file_name, std::ios::ate);
+	std::ifstream cache(file_name + ".astc", std::ios::binary | std::ios::ate);
+
+	std::cout << "source: " << source.tellg() / 1024 << " KB, cache: " << cache.tellg() / 1024 << " KB\n";
+	std::cout << "cold (lex + parse + write cache): " << cold << " ms, " << cold_count << " expressions\n";
+	std::cout << "warm (load cache): " << warm << " ms, " << warm_count << " expressions\n";
+
+	source.close();
+	cache.close();
+	std::remove(file_name.c_str());
+	std::remove((file_name + ".astc").c_str());
+}
+
+static std::string read_file(const std::string& file_name)
+{
+	std::ifstream stream(file_name, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string& file_name, const std::string& content)
+{
+	std::ofstream stream(file_name, std::ios::binary | std::ios::trunc);
+	stream << content;
+}
+
+// Resolves and runs an already parsed program, returning what it printed
+static std::string run_parsed(AST_Parser& parser)
+{
+	std::ostringstream output;
+	std::streambuf* out = std::cout.rdbuf(output.rdbuf());
+
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
+
+	AST_Eval eval(parser);
+	eval.init();
+	eval.global_scope->SCOPE().slots.resize(globals);
+	for (auto& expr : parser.expressions)
+	{
+		eval.eval(expr);
+	}
+
+	std::cout.rdbuf(out);
+	return output.str();
+}
+
+void ast_cache_test()
+{
+	const std::string file_name = "ast_cache_test.txt";
+	const std::string source =
+		"def scale(a, b) { return a * b + 1; }\n"
+		"Config { name = \"cfg\"; size = 17; };\n"
+		"i = 0; items = [1, 2];\n"
+		"while (i != 3) { i = i + 1; if (i == 2) { items = items + [5]; } }\n"
+		"print(Config::name, \" \", scale(Config::size, 2), \" \", items, \" \", i);\n";
+
+	const char* damages[] = { "truncated cache", "flipped payload byte", "bumped version", "same-size source edit" };
+	int failures = 0;
+
+	for (int damage = 0; damage < 4; damage++)
+	{
+		write_file(file_name, source);
+		std::remove((file_name + ".astc").c_str());
+
+		// A cold parse writes the cache, which then gets damaged or goes stale
+		{
+			Lexer lexer(file_name);
+			parse_cached(lexer);
+		}
+
+		std::string cache = read_file(file_name + ".astc");
+		switch (damage)
+		{
+		case 0:
+			cache.resize(cache.size() / 2);
+			break;
+		case 1:
+			cache.back() ^= 0x20;
+			break;
+		case 2:
+			// The version follows the 4-byte magic
+			cache[4]++;
+			break;
+		case 3:
+			write_file(file_name, std::string(source).replace(source.find("17"), 2, "42"));
+			break;
+		}
+		write_file(file_name + ".astc", cache);
+
+		// Whatever parse_cached does must match a plain parse, and leave a cache of that parse behind
+		Lexer fresh_lexer(file_name);
+		AST_Parser fresh(fresh_lexer);
+		fresh.parse();
+		save_ast_cache(file_name + ".fresh", read_file(file_name), fresh.expressions);
+
+		Lexer lexer(file_name);
+		AST_Parser cached = parse_cached(lexer);
+
+		std::string rewritten = read_file(file_name + ".astc");
+		bool same_tree = rewritten == read_file(file_name + ".fresh.astc");
+		std::string fresh_output = run_parsed(fresh);
+		std::string cached_output = run_parsed(cached);
+
+		std::cout << damages[damage] << ": " << (same_tree ? "same tree" : "different tree") << ", "
+			<< (rewritten != cache ? "cache rewritten" : "cache left as is") << ", printed " << cached_output << "\n";
+
+		if (!same_tree || rewritten == cache || cached_output != fresh_output || fresh_output.empty())
+		{
+			std::cout << "failed: a plain parse printed " << fresh_output << "\n";
+			failures++;
+		}
+	}
+
+	std::remove(file_name.c_str());
+	std::remove((file_name + ".astc").c_str());
+	std::remove((file_name + ".fresh.astc").c_str());
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void ast_memory_benchmark()
+{
+	const std::string file_name = "ast_memory_bench.txt";
+
+	{
+		std::ofstream stream(file_name);
+		for (int i = 0; i < 25000; i++)
+		{
+			stream << "x" << i << " = " << i << " + y * 2;\n";
+			stream << "if (x" << i << " == 3) { print(\"hello\"); }\n";
+			stream << "def g" << i << "(a) { return a + 1; }\n";
+			stream << "S" << i << " { v = \"str\"; w = [1, 2, 3]; };\n";
+		}
+	}
+
+	Lexer lexer(file_name);
+	lexer.tokenize();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	AST_Parser parser(lexer);
+	parser.parse();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	// Every arena allocation is one node together with its control block
+	auto& arena = *parser.arena;
+	std::cout << "sizeof(AST_Node): " << sizeof(AST_Node) << " bytes\n";
+	std::cout << "100k lines: " << arena.allocations << " nodes, " << arena.allocated / (1024 * 1024) << " MB in the arena, "
+		<< arena.allocated / arena.allocations << " bytes/node\n";
+	std::cout << "parse: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+
+	std::remove(file_name.c_str());
+}
+
+void binary_op_benchmark()
+{
+	AST_Eval eval;
+	eval.init();
+
+	auto value = [](Type type)
+	{
+		auto node = std::make_shared<AST_Node>(type);
+		node->INT.value = 7;
+		node->FLOAT.value = 2.5;
+		node->BOOL.value = true;
+		return node;
+	};
+
+	auto node = std::make_shared<AST_Node>(TYPE_PLUS);
+
+	// The common pairs, then ones further down the old if/else chains
+	std::vector<std::pair<std::shared_ptr<AST_Node>, std::shared_ptr<AST_Node>>> pairs =
+	{
+		{ value(TYPE_INT), value(TYPE_INT) },
+		{ value(TYPE_FLOAT), value(TYPE_FLOAT) },
+		{ value(TYPE_INT), value(TYPE_FLOAT) },
+		{ value(TYPE_BOOL), value(TYPE_INT) },
+		{ value(TYPE_BOOL), value(TYPE_FLOAT) },
+	};
+
+	const int operations = 1000000;
+
+	for (auto& pair : pairs)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < operations; i++)
+		{
+			eval.apply_plus(node, pair.first, pair.second);
+			eval.apply_minus(node, pair.first, pair.second);
+			eval.apply_mul(node, pair.first, pair.second);
+			eval.apply_div(node, pair.first, pair.second);
+			eval.apply_eq_check(node, pair.first, pair.second);
+			eval.apply_not_eq_check(node, pair.first, pair.second);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		std::cout << type_repr(pair.first->type) << ", " << type_repr(pair.second->type) << ": "
+			<< std::chrono::duration<double, std::nano>(end - start).count() / (6.0 * operations) << " ns/op\n";
+	}
+
+	// An arithmetic-heavy loop through the tree walker, 8 binary operators per iteration
+	const int iterations = 200000;
+	std::string source = "i = 0; s = 0.5; f = 0.5; while (i != " + std::to_string(iterations) + ") { s = s + i * 3 - i / 2; f = f * 1.5 - f; i = i + 1; }";
+
+	for (bool quicken : { false, true })
+	{
+		Lexer lexer(source, false);
+		AST_Parser parser(lexer);
+		parser.parse();
+		AST_Resolver resolver;
+		int globals = resolver.resolve(parser.expressions);
+
+		AST_Eval loop(parser);
+		loop.quicken = quicken;
+		loop.init();
+		loop.global_scope->SCOPE().slots.resize(globals);
+
+		Quickening_Stats before = quickening_stats();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto& expr : parser.expressions)
+		{
+			loop.eval(expr);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		std::cout << "loop (" << (quicken ? "quickened" : "generic") << "): "
+			<< std::chrono::duration<double, std::nano>(end - start).count() / (8.0 * iterations) << " ns/op, "
+			<< quickening_stats().quickened - before.quickened << " sites quickened\n";
+	}
+}
+
+void call_benchmark()
+{
+	// Small user calls and recursion, which push and pop a frame per call
+	const int calls = 100000;
+	std::string source = "def add(a, b) { return a + b; } def fib(n) { if (n == 0) { return 0; } if (n == 1) { return 1; } return fib(n - 1) + fib(n - 2); }"
+		"i = 0; s = 0; while (i != " + std::to_string(calls) + ") { s = add(s, i); i = i + 1; } r = fib(20);";
+
+	// fib(20) makes 21891 calls
+	const int total = calls + 21891;
+
+	for (bool vm : { false, true })
+	{
+		Lexer lexer(source, false);
+		AST_Parser parser(lexer);
+		parser.parse();
+		AST_Resolver resolver;
+		int globals = resolver.resolve(parser.expressions);
+
+		VM machine(parser);
+		machine.init();
+		AST_Eval& eval = machine.eval;
+		eval.global_scope->SCOPE().slots.resize(globals);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		if (vm)
+		{
+			AST_Compiler compiler;
+			machine.run(compiler.compile(parser.expressions));
+		}
+		else
+		{
+			for (auto& expr : parser.expressions)
+			{
+				eval.eval(expr);
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		std::cout << (vm ? "vm" : "tree") << " calls: " << std::chrono::duration<double, std::nano>(end - start).count() / total << " ns/call, "
+			<< eval.frames_allocated << " frames allocated\n";
+	}
+}
+
+void lazy_parse_benchmark()
+{
+	const int functions = 20000;
+	std::string source;
+
+	// A large library of which the program only ever calls a few functions
+	for (int i = 0; i < functions; i++)
+	{
+		source += "def f" + std::to_string(i) + "(a, b) { c = a * " + std::to_string(i) + " + b / 2.5; if (c == 0) { return \"zero\"; } "
+			"while (c > 0) { c = c - 1; } def g(d) { return d + 1; } return g(c); }\n";
+	}
+	source += "r = f1(1, 2) + f2(3, 4) + f3(5, 6);\n";
+
+	for (bool lazy : { false, true })
+	{
+		Lazy_Body_Stats before = lazy_body_stats();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Lexer lexer(source, false);
+		AST_Parser parser(lexer);
+		parser.lazy_bodies = lazy;
+		parser.parse();
+		AST_Resolver resolver;
+		int globals = resolver.resolve(parser.expressions);
+		auto parsed = std::chrono::high_resolution_clock::now();
+
+		AST_Eval eval(parser);
+		eval.init();
+		eval.global_scope->SCOPE().slots.resize(globals);
+		for (auto& expr : parser.expressions)
+		{
+			eval.eval(expr);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		int deferred = lazy_body_stats().deferred - before.deferred;
+		int materialized = lazy_body_stats().materialized - before.materialized;
+
+		std::cout << (lazy ? "lazy" : "eager") << ": parse " << std::chrono::duration<double, std::milli>(parsed - start).count() << " ms, "
+			<< "parse + run " << std::chrono::duration<double, std::milli>(end - start).count() << " ms, "
+			<< parser.arena->allocations << " nodes, " << parser.arena->allocated / 1024 << " KB in the arena\n";
+		std::cout << "  bodies deferred: " << deferred << ", materialized: " << materialized
+			<< ", never materialized: " << deferred - materialized << "\n";
+	}
+}
+
+void lexer_benchmark()
+{
+	std::string source;
+
+	for (int i = 0; i < 100000; i++)
+	{
+		source += "// record " + std::to_string(i) + "\n";
+		source += "total_" + std::to_string(i) + " = (a + b * 3) - c / 2 % 7;\n";
+		source += "if (x >= 10 && y != 4 || z <= 2) { z += 1; w--; n++; } else { q = [1, 2.5, \"name\"]; };\n";
+		source += "def f(a, b) => a -> b::c; /* note */\n";
+		source += "obj.field = !flag == other; t -= 3 ^ 2;\n";
+	}
+
+	double megabytes = source.size() / (1024.0 * 1024.0);
+	double best = 0;
+	size_t count = 0;
+
+	for (int run = 0; run < 5; run++)
+	{
+		Lexer lexer(source, false);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		lexer.tokenize();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		best = std::max(best, megabytes / seconds);
+		count = lexer.tokens.size();
+	}
+
+	std::cout << "source: " << megabytes << " MB, " << count << " tokens\n";
+	std::cout << "tokenize: " << best << " MB/s (best of 5)\n";
+
+	unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+	best = 0;
+
+	for (int run = 0; run < 5; run++)
+	{
+		Lexer lexer(source, false);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		lexer.tokenize_parallel(threads, Lexer::PARALLEL_CHUNK);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		best = std::max(best, megabytes / std::chrono::duration<double>(end - start).count());
+	}
+
+	std::cout << "tokenize_parallel (" << threads << " threads): " << best << " MB/s (best of 5)\n";
+}
+
+// Flattens a tokenized lexer into a comparable string
+static std::string dump_tokens(Lexer& lexer)
+{
+	std::string result = std::to_string(lexer.has_errors) + "\n";
+	for (auto& token : lexer.tokens.tokens)
+	{
+		result += std::to_string(token.type) + " " + std::to_string(token.offset) + " "
+			+ std::to_string(token.int_value) + " " + std::string(lexer.tokens.text(token)) + "\n";
+	}
+	return result;
+}
+
+// Tokenizes 'source' with the given kernels and flattens the result into a comparable string
+static std::string scan_tokens(const std::string& source, const Scan_Kernels* kernels)
+{
+	Lexer lexer(source, false);
+	lexer.scanner = kernels;
+
+	std::streambuf* out = std::cout.rdbuf(nullptr);
+	lexer.tokenize();
+	std::cout.rdbuf(out);
+
+	return dump_tokens(lexer);
+}
+
+void lexer_scan_test()
+{
+	std::vector<std::string> sources;
+
+	// Runs of every length around the 16 and 32 byte block sizes, ended by each kind of byte
+	for (int length = 0; length <= 70; length++)
+	{
+		for (std::string end : { std::string(" "), std::string("\n"), std::string("("), std::string("\""), std::string("\\"),
+			std::string("*"), std::string("/"), std::string("*/"), std::string(1, '\0'), std::string("\xC3\xA9"), std::string() })
+		{
+			std::string identifier = "a" + std::string(length, 'z') + "_9Z";
+			std::string body(length, 'x');
+			std::string spaces;
+			for (int i = 0; i < length; i++)
+			{
+				spaces += i % 3 ? ' ' : '\t';
+			}
+
+			sources.push_back(identifier + end + identifier);
+			sources.push_back(spaces + end + "x");
+			sources.push_back("\"" + body + end + "\" y");
+			sources.push_back("// " + body + end + "\nz");
+			sources.push_back("/* " + body + end + " */ w");
+			sources.push_back("/* a /* " + body + end + " */ b */ c");
+		}
+	}
+
+	std::string program;
+	for (int i = 0; i < 2000; i++)
+	{
+		program += "value_" + std::to_string(i) + "    =\t\"some string " + std::to_string(i) + "\"; // trailing comment\n";
+		program += "/* block\n   comment */ if (x_long_identifier_name >= 10) { print(\"esc\\n\"); }\n";
+	}
+	sources.push_back(program);
+
+	int failures = 0;
+
+	for (Scan_Mode mode : { SCAN_SSE2, SCAN_AVX2 })
+	{
+		const Scan_Kernels* kernels = get_scan_kernels(mode);
+		if (!kernels)
+		{
+			std::cout << scan_mode_name(mode) << ": not supported, skipped\n";
+			continue;
+		}
+
+		int mismatches = 0;
+		for (auto& source : sources)
+		{
+			if (scan_tokens(source, kernels) != scan_tokens(source, get_scan_kernels(SCAN_SCALAR)))
+			{
+				mismatches++;
+			}
+		}
+
+		std::cout << scan_mode_name(mode) << ": " << sources.size() - mismatches << "/" << sources.size() << " sources match scalar\n";
+		failures += mismatches;
+	}
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+void lexer_parallel_test()
+{
+	std::vector<std::string> sources;
+
+	std::string program;
+	for (int i = 0; i < 300; i++)
+	{
+		program += "value_" + std::to_string(i) + " = \"some string " + std::to_string(i) + "\"; // trailing comment\n";
+		program += "/* block\n   comment /* nested\n */ */ if (x >= 10) { print(\"esc\\n\\t\"); }\n";
+		program += "text = \"spans\n" + std::to_string(i) + "\n  three lines\\n\";\n";
+		program += "n = 3.5 + 12;\n\n";
+	}
+	sources.push_back(program);
+
+	// Chunks starting inside these read code that isn't there: an unterminated string, an
+	// unterminated comment and an integer out of range
+	sources.push_back("a = \"\nb = \"c\nd\" e\n\"\n/*\nf = \"\n*/ g\nh = \"\n99999999999999999999999\n\"\n");
+
+	// The sequential lexer stops at the first NUL
+	sources.push_back("a = 1\nb = 2\n" + std::string(1, '\0') + "\nc = 3\n");
+
+	// Errors, including one in the last chunk, are reported by the sequential lexer
+	sources.push_back("a = 1\nb = 1.2.3\nc = \"d\n");
+	sources.push_back("a = 1\nb = 2\n/* never closed\nc\n");
+	sources.push_back("\n\n\n");
+	sources.push_back("");
+
+	int failures = 0;
+	int checks = 0;
+
+	for (auto& source : sources)
+	{
+		std::string expected = scan_tokens(source, &default_scan_kernels());
+
+		for (unsigned threads : { 2, 4, 8 })
+		{
+			for (size_t chunk_size : { 1, 7, 64, 1000 })
+			{
+				Lexer lexer(source, false);
+
+				std::streambuf* out = std::cout.rdbuf(nullptr);
+				lexer.tokenize_parallel(threads, chunk_size);
+				std::cout.rdbuf(out);
+
+				checks++;
+				if (dump_tokens(lexer) != expected)
+				{
+					failures++;
+				}
+			}
+		}
+	}
+
+	std::cout << checks - failures << "/" << checks << " parallel tokenizations match sequential\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void source_location_test()
+{
+	// Source, byte offset, then the line and column it should map to
+	struct Case { std::string source; uint32_t offset; int line; int column; };
+	std::vector<Case> cases =
+	{
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 0, 1, 1 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 6, 1, 7 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 7, 2, 1 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 12, 2, 6 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 22, 3, 8 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 23, 3, 9 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 24, 4, 1 },
+		{ "a = 1;\nbb = 2;\nccc = 3;\n", 500, 4, 1 },
+		{ "x;\n\n\ny;", 3, 2, 1 },
+		{ "x;\n\n\ny;", 5, 4, 1 },
+		{ "x;\n\n\ny;", 6, 4, 2 },
+		{ "x;\n\n\ny;", 7, 4, 3 },
+		{ "a;\r\nb;\r\n", 2, 1, 3 },
+		{ "a;\r\nb;\r\n", 4, 2, 1 },
+		{ "a;\r\nb;\r\n", 8, 3, 1 },
+		{ "", 0, 1, 1 },
+	};
+
+	int failures = 0;
+
+	for (auto& test : cases)
+	{
+		auto source = Source_Buffer::from_string(test.source);
+		Source_Location location = source->location(test.offset);
+
+		if (location.line != test.line || location.column != test.column)
+		{
+			std::cout << "failed: offset " << test.offset << " -> (" << location.line << ", " << location.column << ")\n";
+			failures++;
+		}
+	}
+
+	// Every offset of these sources against counting newlines by hand
+	std::vector<std::string> sources = { "one\ntwo\n\nfour", "\n\n", "a;\r\nb;\r\n\r\nc;", std::string(300, 'x') + "\n" + std::string(5, 'y') };
+	for (auto& text : sources)
+	{
+		auto source = Source_Buffer::from_string(text);
+		Source_Location expected;
+
+		for (uint32_t offset = 0; offset <= text.size(); offset++)
+		{
+			Source_Location location = source->location(offset);
+			if (location.line != expected.line || location.column != expected.column)
+			{
+				std::cout << "failed: offset " << offset << " of a " << text.size() << " byte source\n";
+				failures++;
+				break;
+			}
+
+			if (offset < text.size() && text[offset] == '\n')
+			{
+				expected = { expected.line + 1, 1 };
+			}
+			else
+			{
+				expected.column++;
+			}
+		}
+	}
+
+	// The lexer rejects '\r' where it is, and the token after a \r\n starts its line
+	Lexer lexer("a = 1;\r\nbb = 2;", false);
+	std::streambuf* out = std::cout.rdbuf(nullptr);
+	lexer.tokenize();
+	std::cout.rdbuf(out);
+
+	int checked = 0;
+	for (size_t i = 0; i < lexer.tokens.size(); i++)
+	{
+		Token& token = lexer.tokens[i];
+		Source_Location location = lexer.tokens.source->location(token.offset);
+		checked += token.type == TYPE_ERROR || lexer.tokens.text(token) == "bb";
+
+		bool is_cr = token.type == TYPE_ERROR && (location.line != 1 || location.column != 7);
+		bool is_bb = lexer.tokens.text(token) == "bb" && (location.line != 2 || location.column != 1);
+		if (is_cr || is_bb)
+		{
+			std::cout << "failed: token " << i << " of the \\r\\n source at (" << location.line << ", " << location.column << ")\n";
+			failures++;
+		}
+	}
+	if (checked != 2)
+	{
+		std::cout << "failed: the \\r\\n source lexed to " << lexer.tokens.size() << " tokens\n";
+		failures++;
+	}
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void lexer_string_test()
+{
+	// Source, then the decoded text, or nothing for an unterminated literal
+	std::vector<std::pair<std::string, std::string>> cases =
+	{
+		{ "\"plain\"", "plain" },
+		{ "\"a\\nb\\rc\\td\"", "a\nb\rc\td" },
+		{ "\"keep \\x and \\\\n\"", "keep \\x and \\\n" },
+		{ "\"trailing \\\"", "trailing \\" },
+		{ "\"two\nlines\"", "twolines" },
+		{ "\"blank\n\nline\"", "blank\nline" },
+		{ "\"quote\n\" kept\"", "quote\" kept" },
+		{ "\"split \\\nn\"", "split \n" },
+		{ "\"" + std::string(40, 'x') + "\\n" + std::string(40, 'y') + "\"", std::string(40, 'x') + "\n" + std::string(40, 'y') },
+		{ "\"open", "" },
+		{ "\"open\n", "" },
+		{ "\"nul " + std::string(1, '\0') + "\"", "" },
+	};
+
+	int failures = 0;
+
+	for (auto& [source, expected] : cases)
+	{
+		Lexer lexer(source, false);
+
+		std::streambuf* out = std::cout.rdbuf(nullptr);
+		lexer.tokenize();
+		std::cout.rdbuf(out);
+
+		Token& token = lexer.tokens[0];
+		bool passed = expected.empty()
+			? lexer.has_errors && token.type == TYPE_EOF
+			: !lexer.has_errors && token.type == TYPE_STRING && lexer.tokens.text(token) == expected;
+
+		if (!passed)
+		{
+			std::cout << "failed: " << source << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << cases.size() - failures << "/" << cases.size() << " string literals decoded\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void lexer_number_test()
+{
+	// Source, then its tokens up to EOF, or nothing for a lexer error. Whatever fit in an int
+	// lexes as it did with std::stoi and std::stof.
+	std::vector<std::pair<std::string, std::string>> cases =
+	{
+		{ "0", "INT(0)" },
+		{ "2147483648", "INT(2147483648)" },
+		{ "9223372036854775807", "INT(9223372036854775807)" },
+		{ "9223372036854775808", "" },
+		{ "0.1", "FLOAT(0.1)" },
+		{ "1.5e3", "FLOAT(1.5) ID(e3)" },
+		{ "1" + std::string(400, '0') + ".5", "" },
+		{ ".5", "TOKEN(.) INT(5)" },
+		{ "5.", "FLOAT(5)" },
+		{ "1.2.3", "" },
+	};
+
+	int failures = 0;
+
+	for (auto& [source, expected] : cases)
+	{
+		Lexer lexer(source, false);
+
+		std::streambuf* out = std::cout.rdbuf(nullptr);
+		lexer.tokenize();
+
+		std::ostringstream tokens;
+		std::cout.rdbuf(tokens.rdbuf());
+		for (size_t i = 0; i + 1 < lexer.tokens.size(); i++)
+		{
+			print_token(lexer.tokens, lexer.tokens[i]);
+			tokens << " ";
+		}
+		std::cout.rdbuf(out);
+
+		std::string printed = tokens.str();
+		bool passed = expected.empty()
+			? lexer.has_errors
+			: !lexer.has_errors && printed == expected + " ";
+
+		if (!passed)
+		{
+			std::cout << "failed: " << source << " -> " << printed << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << cases.size() - failures << "/" << cases.size() << " number literals lexed\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void parser_precedence_test()
+{
+	// Expression, then its tree as print_ast_node writes it. The trees are the ones the parser
+	// built before expressions were built in one pass.
+	std::vector<std::pair<std::string, std::string>> cases =
+	{
+		{ "a - b - c;", "( ( a - b ) - c )" },
+		{ "a / b / c;", "( ( a / b ) / c )" },
+		{ "2 * 3 + 4 == 10;", "( ( ( 2 * 3 ) + 4 ) == 10 )" },
+		{ "1 + 2 * 3 - 4 / 2;", "( ( 1 + ( 2 * 3 ) ) - ( 4 / 2 ) )" },
+		{ "-a::b;", "( -neg ( a :: b ) )" },
+		{ "-a::b * 2;", "( ( -neg ( a :: b ) ) * 2 )" },
+		{ "a - -b;", "( a - ( -neg b ) )" },
+		{ "-a - b;", "( ( -neg a ) - b )" },
+		{ "a::b::c;", "( ( a :: b ) :: c )" },
+		{ "a.b.c;", "( ( a . b ) . c )" },
+		{ "a.b::c + d;", "( ( ( a . b ) :: c ) + d )" },
+		{ "i++;", "( i ++ )" },
+		{ "i++ + 1;", "( ( i ++ ) + 1 )" },
+		{ "a + i++ * 2;", "( a + ( ( i ++ ) * 2 ) )" },
+		{ "i-- - j--;", "( ( i -- ) - ( j -- ) )" },
+		{ "x = y = 3;", "( ( x = y ) = 3 )" },
+		{ "x = a + b * c;", "( x = ( a + ( b * c ) ) )" },
+		{ "x += a - b;", "( x += ( a - b ) )" },
+		{ "(a + b) * c;", "( ( a + b ) * c )" },
+		{ "a * (b - c) - d;", "( ( a * ( b - c ) ) - d )" },
+		{ "f(a, b) + g(c) * 2;", "( CALL(name: f, args: [ a, b ]) + ( CALL(name: g, args: [ c ]) * 2 ) )" },
+		{ "a < b == c >= d;", "( ( ( a < b ) == c ) >= d )" },
+		{ "[1, 2] + [a - b];", "( LIST[ 1, 2 ] + LIST[ ( a - b ) ] )" },
+		{ "a -> b;", "( a -> b )" },
+	};
+
+	int failures = 0;
+
+	for (auto& [source, expected] : cases)
+	{
+		Lexer lexer(source, false);
+		AST_Parser parser(lexer);
+
+		std::ostringstream tree;
+		std::streambuf* out = std::cout.rdbuf(nullptr);
+		parser.parse();
+		std::cout.rdbuf(tree.rdbuf());
+		if (parser.expressions.size() == 1)
+		{
+			print_ast_node(parser.expressions[0]);
+		}
+		std::cout.rdbuf(out);
+
+		if (tree.str() != expected)
+		{
+			std::cout << "failed: " << source << " -> " << tree.str() << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << cases.size() - failures << "/" << cases.size() << " expressions parsed\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+// Runs 'source' to completion and returns what it printed
+static std::string run_captured(const std::string& source, bool quicken)
+{
+	std::ostringstream output;
+	std::streambuf* out = std::cout.rdbuf(output.rdbuf());
+
+	Lexer lexer(source, false);
+	AST_Parser parser(lexer);
+	parser.parse();
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
+
+	AST_Eval eval(parser);
+	eval.quicken = quicken;
+	eval.init();
+	eval.global_scope->SCOPE().slots.resize(globals);
+	for (auto& expr : parser.expressions)
+	{
+		if (eval.eval(expr)->type == TYPE_ERROR)
+		{
+			break;
+		}
+	}
+
+	std::cout.rdbuf(out);
+	return output.str();
+}
+
+static std::string run_captured_vm(const std::string& source)
+{
+	std::ostringstream output;
+	std::streambuf* out = std::cout.rdbuf(output.rdbuf());
+
+	Lexer lexer(source, false);
+	AST_Parser parser(lexer);
+	parser.parse();
+	AST_Resolver resolver;
+	int globals = resolver.resolve(parser.expressions);
+
+	VM vm(parser);
+	vm.init();
+	vm.eval.global_scope->SCOPE().slots.resize(globals);
+
+	AST_Compiler compiler;
+	auto chunk = compiler.compile(parser.expressions);
+	vm.run(chunk);
+
+	std::cout.rdbuf(out);
+	return output.str();
+}
+
+void quickening_test()
+{
+	// Each program runs its sites hot with one pair of types, then changes them. Floats are
+	// printed through str(), since print() writes them with printf.
+	std::vector<std::string> programs =
+	{
+		"i = 0; s = 0; while (i != 20) { s = s + i * 2 - 1; i = i + 1; } print(s, \" \", str(i / 4));",
+		"def f(a, b) { return a * b - a / b; } i = 0; while (i != 12) { print(str(f(i + 1, 2)), \" \"); i = i + 1; } print(str(f(1.5, 2.5)), f(\"ab\", 2));",
+		"def eq(a, b) { return a == b; } def ne(a, b) { return a != b; } i = 0; while (i != 10) { print(eq(i, 3), ne(i, 3)); i = i + 1; } "
+			"print(eq(\"x\", \"x\"), ne(2.5, 2.5), eq(1, 1.0), ne([1], [1]), str(2.5 / 2.0));",
+		"y = \"outer\"; def g(flag) { if (flag == 1) { y = 5; } return y; } i = 0; while (i != 10) { print(g(1)); i = i + 1; } print(g(0), g(1));",
+		"def h(v) { return v + v; } i = 0; while (i != 10) { print(str(h(1.25))); i = i + 1; } print(h(true), h(\"s\"), h([1]), h(2));",
+		"def m(a) { return a - 1; } i = 0; while (i != 10) { m(i); i = i + 1; } print(m(undefined_thing));",
+	};
+
+	Quickening_Stats before = quickening_stats();
+	int failures = 0;
+
+	for (auto& program : programs)
+	{
+		std::string quickened = run_captured(program, true);
+		std::string generic = run_captured(program, false);
+
+		if (quickened != generic)
+		{
+			std::cout << "failed: " << program << "\n  quickened: " << quickened << "\n  generic: " << generic << "\n";
+			failures++;
+		}
+	}
+
+	int quickened = quickening_stats().quickened - before.quickened;
+	int deoptimized = quickening_stats().deoptimized - before.deoptimized;
+	if (quickened == 0 || deoptimized == 0)
+	{
+		std::cout << "failed: expected sites to be quickened and deoptimized\n";
+		failures++;
+	}
+
+	std::cout << programs.size() << " programs, " << quickened << " sites quickened, " << deoptimized << " deoptimized\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void value_test()
+{
+	int failures = 0;
+	auto check = [&](bool ok, const std::string& what)
+	{
+		if (!ok)
+		{
+			std::cout << "failed: " << what << "\n";
+			failures++;
+		}
+	};
+
+	for (int64_t value : { (int64_t)0, (int64_t)-1, (int64_t)42, Value::MIN_INT, Value::MAX_INT })
+	{
+		Value word = Value::from_int(value);
+		check(word.is_int() && word.as_int() == value && word.type() == TYPE_INT, "int " + std::to_string(value));
+	}
+	check(!Value::fits_int(Value::MAX_INT + 1) && !Value::fits_int(Value::MIN_INT - 1), "int range");
+
+	for (double value : { 0.0, -0.0, 1.5, -2.25e300, std::numeric_limits<double>::infinity() })
+	{
+		Value word = Value::from_float(value);
+		check(word.is_float() && std::memcmp(&value, &word, sizeof(value)) == 0 && word.type() == TYPE_FLOAT,
+			"float " + std::to_string(value));
+	}
+
+	uint64_t boxed_nan = 0xFFFD000000000001;
+	double nan;
+	std::memcpy(&nan, &boxed_nan, sizeof(nan));
+	check(Value::from_float(nan).is_float() && std::isnan(Value::from_float(nan).as_float()), "boxed-looking NaN");
+	check(Value::from_float(0.0 / 0.0).is_float(), "NaN");
+
+	check(Value::from_bool(true).as_bool() && !Value::from_bool(false).as_bool() && Value::from_bool(true).type() == TYPE_BOOL, "bool");
+	check(Value().is_empty() && Value().type() == TYPE_EMPTY, "empty");
+
+	AST_Node list(TYPE_LIST);
+	check(Value::from_object(&list).as_object() == &list && Value::from_object(&list).type() == TYPE_LIST, "object");
+	AST_Node wide(TYPE_INT);
+	wide.INT.value = Value::MAX_INT + 1;
+	check(to_value(wide).is_object() && to_node(Value::from_int(-7))->INT.value == -7, "boxing");
+
+	// Assignment copies values, and ints leave the 48-bit range inside hot loops
+	std::vector<std::pair<std::string, std::string>> programs =
+	{
+		{ "a = 5; b = a; a = 7; print(b);", "5" },
+		{ "l = [1, 2]; m = l; l = [3]; print(m);", "LIST[ 1, 2 ]" },
+		{ "def f(a) { return a * 2; } g = f; print(g(4));", "8" },
+		{ "def f(x) { x = x + 1; return x; } c = 1; i = 0; while (i != 10) { f(c); i = i + 1; } print(c);", "1" },
+		{ "big = 140737488355320; i = 0; while (i != 10) { big = big + 1; i = i + 1; } print(big, \" \", big - big);", "140737488355330 0" },
+		{ "x = -140737488355320; i = 0; while (i != 10) { x = x - 1; i = i + 1; } print(x, \" \", x == x);", "-140737488355330 1" },
+		{ "i = 0; p = 1; while (i != 30) { p = p * 4; i = i + 1; } print(p);", "1152921504606846976" },
+		{ "s = 0.5; i = 0; while (i != 10) { s = s * 2.0; i = i + 1; } print(str(s), \" \", i == 10, \" \", type_of(s));", "512.000000 1 float" },
+	};
+
+	for (auto& program : programs)
+	{
+		std::string quickened = run_captured(program.first, true);
+		std::string generic = run_captured(program.first, false);
+
+		if (quickened != program.second || generic != program.second)
+		{
+			std::cout << "failed: " << program.first << "\n  quickened: " << quickened << "\n  generic: " << generic << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void type_test()
+{
+	int failures = 0;
+	auto check = [&](bool ok, const std::string& what)
+	{
+		if (!ok)
+		{
+			std::cout << "failed: " << what << "\n";
+			failures++;
+		}
+	};
+
+	check(find_type("int") == TID_INT && find_type("scope") == TID_SCOPE && type_name(TID_FLOAT) == "float", "built-in ids");
+	check(find_type("Registry_Test_Point") == -1, "unknown type");
+
+	run_captured("type Registry_Test_Point { x = 0; }", true);
+	int point = find_type("Registry_Test_Point");
+	check(point >= TID_BUILT_IN_COUNT && !is_built_in_type(point) && register_type("Registry_Test_Point") == point, "user type");
+
+	AST_Eval eval;
+	auto one = std::make_shared<AST_Node>(TYPE_INT);
+	auto type = eval.infer_type(one);
+	check(type == eval.infer_type(one) && type->TYPE().id == TID_INT, "shared type nodes");
+
+	std::vector<std::pair<std::string, std::string>> programs =
+	{
+		{ "f = 1.5; f = 2; print(str(f), \" \", type_of(f));", "2.000000 float" },
+		{ "i = 1; i = 2.7; print(\" \", i, type_of(i));", "\nWarning: Potential data loss... 2int" },
+		{ "b = true; b = 3; print(\" \", b);", "\nWarning: Potential data loss... 1" },
+		{ "i = 1; i = true; print(i, type_of(i));", "1int" },
+		{ "print(type_of(1) == type_of(2), type_of(1) != type_of(1.5), type_of(\"a\"), type_of([1]), type_of(type_of(1)));", "11stringlisttype" },
+	};
+
+	for (auto& program : programs)
+	{
+		std::string output = run_captured(program.first, true);
+		check(output == program.second, program.first + "\n  printed: " + output);
+	}
+
+	std::string error = run_captured("s = \"x\"; s = 1;", true);
+	check(error.find("Cannot assign value of type 'int' to variable of type 'string'.") != std::string::npos, "cast error: " + error);
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void vm_test_programs()
+{
+	// print() writes each argument before evaluating the next, so side effects interleave
+	std::vector<std::string> programs =
+	{
+		"def f() { print(\"A\"); return 1; } print(\"x\", f(), \"y\");",
+		"def f(n) { print(n); return n; } print(f(1), f(2), \" \", f(3));",
+		"print(\"before \", undefined_thing, \" after\");",
+		"def f() { print(\"in f \"); return missing; } print(\"x \", f(), \" y\"); print(\"z\");",
+		"print(); print(\"a\"); i = 0; while (i != 3) { print(i, \",\"); i = i + 1; }",
+
+		// Calls that can't go ahead fail before any of their arguments run
+		"g(print(\"side\\n\"));",
+		"def f(a) { return a; } f(print(\"side\\n\"), 2);",
+	};
+
+	int failures = 0;
+
+	for (auto& program : programs)
+	{
+		std::string tree = run_captured(program, true);
+		std::string vm = run_captured_vm(program);
+
+		if (tree != vm)
+		{
+			std::cout << "failed: " << program << "\n  tree: " << tree << "\n  vm: " << vm << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << programs.size() << " programs\n";
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+void lazy_body_error_test()
+{
+	std::string program = "def f() { x = (1; print(\"in f\"); return 2; } print(f());";
+	int failures = 0;
+
+	// Neither engine may run any of a body that failed to parse
+	std::string tree = run_captured(program, true);
+	std::string vm = run_captured_vm(program);
+	for (auto& output : { tree, vm })
+	{
+		if (output.find("in f") != std::string::npos || output.find("has syntax errors in its body") == std::string::npos)
+		{
+			std::cout << "failed: " << output << "\n";
+			failures++;
+		}
+	}
+
+	// The failure sticks, so later calls don't parse or report the body again
+	std::ostringstream discarded;
+	std::streambuf* out = std::cout.rdbuf(discarded.rdbuf());
+	Lexer lexer(program, false);
+	AST_Parser parser(lexer);
+	parser.parse();
+	auto& func = parser.expressions[0]->FUNC_DEF();
+	bool first = materialize_body(func);
+	bool second = materialize_body(func);
+	std::cout.rdbuf(out);
+
+	if (first || second || !func.body.empty())
+	{
+		std::cout << "failed: the body materialized after a syntax error\n";
+		failures++;
+	}
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
+
+// Counts the nodes under 'node' whose payload isn't the one their type calls for
+static int count_payload_mismatches(std::shared_ptr<AST_Node>& node, int& checked)
+{
+	if (!node)
+	{
+		return 0;
+	}
+
+	checked++;
+	int mismatches = node->payload.index() != payload_for(node->type).index();
+
+	auto walk = [&](std::vector<std::shared_ptr<AST_Node>>& nodes)
+	{
+		for (auto& child : nodes)
+		{
+			mismatches += count_payload_mismatches(child, checked);
+		}
+	};
+
+	mismatches += count_payload_mismatches(node->left, checked);
+	mismatches += count_payload_mismatches(node->right, checked);
+
+	if (auto call = node->find_payload<Call_Node>()) walk(call->args);
+	if (auto func = node->find_payload<Func_Def_Node>())
+	{
+		walk(func->params);
+		walk(func->body);
+		mismatches += count_payload_mismatches(func->return_type, checked);
+	}
+	if (auto block = node->find_payload<Block_Node>()) walk(block->body);
+	if (auto if_node = node->find_payload<If_Node>())
+	{
+		mismatches += count_payload_mismatches(if_node->expr, checked);
+		mismatches += count_payload_mismatches(if_node->body, checked);
+	}
+	if (auto if_statement = node->find_payload<If_Statement_Node>()) walk(if_statement->statements);
+	if (auto list = node->find_payload<List_Node>()) walk(list->items);
+	if (auto while_loop = node->find_payload<While_Node>())
+	{
+		mismatches += count_payload_mismatches(while_loop->expr, checked);
+		walk(while_loop->body);
+	}
+	if (auto ret = node->find_payload<Return_Node>()) mismatches += count_payload_mismatches(ret->value, checked);
+	if (auto type_def = node->find_payload<Type_Def_Node>()) walk(type_def->body);
+
+	return mismatches;
+}
+
+void payload_test()
+{
+	const std::string file_name = "payload_test.txt";
+
+	{
+		std::ofstream stream(file_name);
+		stream << "def f(a, b) { if (a == 1) { return [1, 2]; } else if (a == 2) { return \"two\"; } else { return a * b; } }\n"
+			<< "type Point { x = 0; y = 0.5; }\n"
+			<< "blk { v = f(1, 2); w = f(2, 0) + \"s\"; };\n"
+			<< "i = 0; while (i != 3) { i = i + 1; if (i == 2) { break; } }\n"
+			<< "r = ref(i); print(blk::v, blk::w, f(3, 4), type_of(i), str(true), [1] + [2] * 2, r);\n";
+	}
+
+	std::remove((file_name + ".astc").c_str());
+
+	int failures = 0;
+
+	// Cold parses write the cache, warm ones read it back; running the program mustn't add payloads either
+	for (const char* pass : { "cold", "warm" })
+	{
+		Lexer lexer(file_name);
+		AST_Parser parser = parse_cached(lexer);
+		AST_Resolver resolver;
+		int globals = resolver.resolve(parser.expressions);
+
+		std::ostringstream output;
+		std::streambuf* out = std::cout.rdbuf(output.rdbuf());
+
+		AST_Eval eval(parser);
+		eval.init();
+		eval.global_scope->SCOPE().slots.resize(globals);
+		for (auto& expr : parser.expressions)
+		{
+			eval.eval(expr);
+		}
+
+		std::cout.rdbuf(out);
+
+		int checked = 0;
+		int mismatches = 0;
+		for (auto& expr : parser.expressions)
+		{
+			mismatches += count_payload_mismatches(expr, checked);
+		}
+
+		std::cout << pass << ": " << checked << " nodes, " << mismatches << " with a foreign payload\n";
+		if (mismatches != 0 || output.str() != "LIST[ 1, 2 ]twos12int1LIST[ 1, 2, 2 ]")
+		{
+			std::cout << "failed: printed " << output.str() << "\n";
+			failures++;
+		}
+	}
+
+	std::remove(file_name.c_str());
+	std::remove((file_name + ".astc").c_str());
+
+	std::cout << (failures == 0 ? "PASSED" : "FAILED") << "\n";
+
+	if (failures != 0)
+	{
+		exit(1);
+	}
+}
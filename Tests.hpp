@@ -1,11 +1,59 @@
 #pragma once
+#include <chrono>
+#include <thread>
 
 #include "Lexer.hpp"
 
 #include "AST_Node.hpp"
 #include "AST_Parser.hpp"
 #include "AST_Eval.hpp"
+#include "AST_Cache.hpp"
+#include "VM.hpp"
 
 void ast_node_test();
 
-void ast_parser_test();
\ No newline at end of file
+void ast_parser_test();
+
+void vm_test();
+
+void scope_lookup_benchmark();
+
+void module_cache_test();
+
+void ast_cache_benchmark();
+
+void ast_cache_test();
+
+void ast_memory_benchmark();
+
+void lazy_parse_benchmark();
+
+void binary_op_benchmark();
+
+void call_benchmark();
+
+void lexer_benchmark();
+
+void lexer_scan_test();
+
+void lexer_parallel_test();
+
+void source_location_test();
+
+void lexer_string_test();
+
+void lexer_number_test();
+
+void parser_precedence_test();
+
+void quickening_test();
+
+void value_test();
+
+void type_test();
+
+void vm_test_programs();
+
+void lazy_body_error_test();
+
+void payload_test();
\ No newline at end of file
@@ -1,18 +1,41 @@
 #include "Token.hpp"
 
-const std::string Token::get_id_value()
+bool Token::is_op() const
 {
-	if (type == TYPE_ID)
+	switch (type)
 	{
-		return *id_value;
-	}
-	else
-	{
-		return "";
+	case TYPE_EQ_EQ:
+	case TYPE_NOT_EQUAL:
+	case TYPE_LT_EQUAL:
+	case TYPE_GT_EQUAL:
+	case TYPE_PLUS_EQ:
+	case TYPE_MINUS_EQ:
+	case TYPE_RIGHT_ARROW:
+	case TYPE_RIGHT_ARROW_SINGLE:
+	case TYPE_AND:
+	case TYPE_OR:
+	case TYPE_EQ_AND:
+	case TYPE_EQUAL:
+	case TYPE_LANGLE:
+	case TYPE_RANGLE:
+	case TYPE_CARET:
+	case TYPE_PERCENT:
+	case TYPE_MINUS:
+	case TYPE_PLUS:
+	case TYPE_SLASH:
+	case TYPE_STAR:
+		return true;
+	default:
+		return false;
 	}
 }
 
-int Token::get_int_value()
+bool Token::is_post_op() const
+{
+	return type == TYPE_PLUS_PLUS || type == TYPE_MINUS_MINUS;
+}
+
+int64_t Token::get_int_value() const
 {
 	if (type == TYPE_INT)
 	{
@@ -24,7 +47,7 @@ int Token::get_int_value()
 	}
 }
 
-float Token::get_float_value()
+double Token::get_float_value() const
 {
 	if (type == TYPE_FLOAT)
 	{
@@ -32,15 +55,61 @@ float Token::get_float_value()
 	}
 	else
 	{
-		return 0.0f;
+		return 0.0;
+	}
+}
+
+bool Token::get_bool_value() const
+{
+	if (type == TYPE_BOOL)
+	{
+		return bool_value;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+void Token_Stream::set_window(size_t size)
+{
+	window = size;
+	tokens.resize(size);
+	texts.resize(size);
+	window_decoded.resize(size);
+}
+
+void Token_Stream::push_back(Token token, std::string_view text)
+{
+	if (window)
+	{
+		token.text = slot(count);
+		texts[token.text] = text;
+	}
+	else
+	{
+		token.text = texts.size();
+		texts.push_back(text);
 	}
+	push_back(token);
 }
 
-const std::string Token::get_string_value()
+std::string& Token_Stream::decode_buffer()
 {
-	if (type == TYPE_STRING)
+	if (window)
 	{
-		return *string_value;
+		std::string& buffer = window_decoded[slot(count)];
+		buffer.clear();
+		return buffer;
+	}
+	return decoded.emplace_back();
+}
+
+std::string_view Token_Stream::text(const Token& token) const
+{
+	if (token.type == TYPE_ID || token.type == TYPE_STRING)
+	{
+		return texts[token.text];
 	}
 	else
 	{
@@ -48,39 +117,63 @@ const std::string Token::get_string_value()
 	}
 }
 
-void print_token(std::shared_ptr<Token> token)
+std::string_view Token_Stream::get_id_value(const Token& token) const
 {
-	if (token->type == TYPE_ID)
+	if (token.type == TYPE_ID)
 	{
-		std::cout << type_repr(token->type) << "(" << token->get_id_value() << ")";
+		return texts[token.text];
 	}
-	else if (token->type == TYPE_INT)
+	else
 	{
-		std::cout << type_repr(token->type) << "(" << token->get_int_value() << ")";
+		return "";
 	}
-	else if (token->type == TYPE_FLOAT)
+}
+
+std::string_view Token_Stream::get_string_value(const Token& token) const
+{
+	if (token.type == TYPE_STRING)
 	{
-		std::cout << type_repr(token->type) << "(" << token->get_float_value() << ")";
+		return texts[token.text];
 	}
-	else if (token->type == TYPE_STRING)
+	else
 	{
-		std::cout << type_repr(token->type) << "("
-			<< "\"" << token->get_string_value() << "\"" << ")";
+		return "";
+	}
+}
+
+void print_token(const Token_Stream& stream, const Token& token)
+{
+	if (token.type == TYPE_ID)
+	{
+		std::cout << type_repr(token.type) << "(" << stream.get_id_value(token) << ")";
+	}
+	else if (token.type == TYPE_INT)
+	{
+		std::cout << type_repr(token.type) << "(" << token.get_int_value() << ")";
+	}
+	else if (token.type == TYPE_FLOAT)
+	{
+		std::cout << type_repr(token.type) << "(" << token.get_float_value() << ")";
+	}
+	else if (token.type == TYPE_STRING)
+	{
+		std::cout << type_repr(token.type) << "("
+			<< "\"" << stream.get_string_value(token) << "\"" << ")";
 	}
 	else
 	{
-		std::cout << "TOKEN(" << type_repr(token->type) << ")";
+		std::cout << "TOKEN(" << type_repr(token.type) << ")";
 	}
 }
 
-void print_tokens(std::vector<std::shared_ptr<Token>> tokens)
+void print_tokens(const Token_Stream& stream)
 {
-	std::cout << "\nTokens: " << std::to_string(tokens.size());
+	std::cout << "\nTokens: " << std::to_string(stream.size());
 	std::cout << "\n[ ";
-	for (auto token : tokens)
+	for (auto& token : stream.tokens)
 	{
-		print_token(token);
+		print_token(stream, token);
 		std::cout << " ";
 	}
 	std::cout << " ]";
-}
\ No newline at end of file
+}
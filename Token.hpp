@@ -1,36 +1,101 @@
 #pragma once
 
+#include <cstdint>
+#include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "Type.hpp"
+#include "Source.hpp"
 
+// Tokens are 16-byte values stored contiguously in a Token_Stream. Identifier and string
+// tokens keep an index into the stream's text table instead of the text itself, and every
+// token keeps its byte offset in the source instead of a line and column.
 struct Token
 {
 	Type type = TYPE_EMPTY;
-	int line = 0;
-	int column = 0;
+	uint32_t offset = 0;
 
-	bool is_op = false;
-	bool is_post_op = false;
+	union
+	{
+		int64_t int_value = 0;
+		double float_value;
+		bool bool_value;
+		uint32_t text;
+	};
 
-	int int_value = 0;
-	float float_value = 0.0f;
-	bool bool_value = 0;
+	Token() = default;
+	Token(uint32_t offset) : offset(offset) {}
+	Token(Type type, uint32_t offset) : type(type), offset(offset) {}
 
-	std::shared_ptr<std::string> id_value = nullptr;
-	std::shared_ptr<std::string> string_value = nullptr;
+	bool is_op() const;
 
-	Token(int lexer_line, int lexer_column) : line(lexer_line), column(lexer_column) {}
-	Token(Type type, int lexer_line, int lexer_column) : type(type), line(lexer_line), column(lexer_column) {}
+	bool is_post_op() const;
 
-	const std::string get_id_value();
+	int64_t get_int_value() const;
 
-	int get_int_value();
+	double get_float_value() const;
 
-	float get_float_value();
+	bool get_bool_value() const;
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
+
+// Tokens in lexing order. By default every token is kept; with a window set, only the most
+// recent 'window' tokens are, in a ring, so a streaming parser holds constant token memory.
+// Indexes are always positions in the whole stream.
+struct Token_Stream
+{
+	std::vector<Token> tokens;
+
+	// Views into 'source', or into 'decoded' for string literals with escapes. The list never
+	// moves its strings, so chunks lexed separately can be spliced together.
+	std::vector<std::string_view> texts;
+	std::list<std::string> decoded;
+	std::vector<std::string> window_decoded;
+	std::shared_ptr<Source_Buffer> source = nullptr;
+
+	// Zero, or a power of two
+	size_t window = 0;
+	size_t count = 0;
+
+	// Only valid before any token is added
+	void set_window(size_t size);
+
+	size_t slot(size_t index) const { return window ? index & (window - 1) : index; }
+
+	Token& operator[](size_t index) { return tokens[slot(index)]; }
+
+	size_t size() const { return count; }
+
+	void push_back(const Token& token)
+	{
+		if (window)
+		{
+			tokens[slot(count)] = token;
+		}
+		else
+		{
+			tokens.push_back(token);
+		}
+		count++;
+	}
+
+	// Adds a token whose text is 'text'
+	void push_back(Token token, std::string_view text);
+
+	// Storage for the decoded text of the next token added
+	std::string& decode_buffer();
+
+	// Text of an identifier or string token, empty for anything else
+	std::string_view text(const Token& token) const;
+
+	std::string_view get_id_value(const Token& token) const;
 
-	const std::string get_string_value();
+	std::string_view get_string_value(const Token& token) const;
 };
 
-void print_token(std::shared_ptr<Token> token);
+void print_token(const Token_Stream& stream, const Token& token);
 
-void print_tokens(std::vector<std::shared_ptr<Token>> tokens);
\ No newline at end of file
+void print_tokens(const Token_Stream& stream);
@@ -77,6 +77,14 @@ std::string type_repr(Type type)
 	case TYPE_VAR:					return "VAR";
 	case TYPE_BREAK:				return "BREAK";
 	case TYPE_BREAK_ALL:			return "BREAK_ALL";
+	case TYPE_KW_IF:				return "KW_IF";
+	case TYPE_KW_ELSE:				return "KW_ELSE";
+	case TYPE_KW_WHILE:				return "KW_WHILE";
+	case TYPE_KW_TYPE:				return "KW_TYPE";
+	case TYPE_KW_DEF:				return "KW_DEF";
+	case TYPE_KW_RETURN:			return "KW_RETURN";
+	case TYPE_KW_BREAK:				return "KW_BREAK";
+	case TYPE_KW_BREAK_ALL:			return "KW_BREAK_ALL";
 
 	default: return "NO_REPR";
 	}
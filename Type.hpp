@@ -81,7 +81,21 @@ enum Type
 	TYPE_SCOPE,
 	TYPE_VAR,
 	TYPE_BREAK,
-	TYPE_BREAK_ALL
+	TYPE_BREAK_ALL,
+
+	// Keywords
+
+	TYPE_KW_IF,
+	TYPE_KW_ELSE,
+	TYPE_KW_WHILE,
+	TYPE_KW_TYPE,
+	TYPE_KW_DEF,
+	TYPE_KW_RETURN,
+	TYPE_KW_BREAK,
+	TYPE_KW_BREAK_ALL,
+
+	// Number of types, for tables indexed by Type
+	TYPE_COUNT
 };
 
 std::string type_repr(Type type);
\ No newline at end of file
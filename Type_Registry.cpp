@@ -0,0 +1,75 @@
+#include "Type_Registry.hpp"
+#include <unordered_map>
+#include <vector>
+
+struct Type_Registry
+{
+	std::unordered_map<std::string, int> ids;
+	std::vector<std::string> names;
+
+	Type_Registry()
+	{
+		for (const char* name : { "", "int", "float", "bool", "string", "list", "type", "scope", "any" })
+		{
+			ids.emplace(name, (int)names.size());
+			names.push_back(name);
+		}
+	}
+};
+
+static Type_Registry& registry()
+{
+	static Type_Registry types;
+	return types;
+}
+
+int register_type(const std::string& name)
+{
+	auto& types = registry();
+	auto type = types.ids.emplace(name, (int)types.names.size());
+	if (type.second)
+	{
+		types.names.push_back(name);
+	}
+	return type.first->second;
+}
+
+int find_type(const std::string& name)
+{
+	auto& types = registry();
+	auto type = types.ids.find(name);
+	return type == types.ids.end() ? -1 : type->second;
+}
+
+const std::string& type_name(int id)
+{
+	return registry().names[id];
+}
+
+bool is_built_in_type(int id)
+{
+	return id > TID_NONE && id < TID_BUILT_IN_COUNT;
+}
+
+int value_type_id(Type type)
+{
+	switch (type)
+	{
+	case TYPE_INT:
+		return TID_INT;
+	case TYPE_FLOAT:
+		return TID_FLOAT;
+	case TYPE_BOOL:
+		return TID_BOOL;
+	case TYPE_STRING:
+		return TID_STRING;
+	case TYPE_LIST:
+		return TID_LIST;
+	case TYPE_TYPE:
+		return TID_TYPE;
+	case TYPE_SCOPE:
+		return TID_SCOPE;
+	default:
+		return TID_NONE;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include "Type.hpp"
+
+// Type names are registered once into small integer ids, so type checks compare ints instead
+// of strings. The built-in types have fixed ids; user types get theirs when their 'type'
+// definition is parsed.
+enum Type_Id
+{
+	TID_NONE,		// values without a named type: functions, errors, empty results
+	TID_INT,
+	TID_FLOAT,
+	TID_BOOL,
+	TID_STRING,
+	TID_LIST,
+	TID_TYPE,
+	TID_SCOPE,
+	TID_ANY,
+	TID_BUILT_IN_COUNT
+};
+
+// Returns the existing id if 'name' is already registered
+int register_type(const std::string& name);
+
+// Returns -1 if no type is called 'name'
+int find_type(const std::string& name);
+
+const std::string& type_name(int id);
+
+bool is_built_in_type(int id);
+
+// The id of values whose nodes have type 'type'
+int value_type_id(Type type);
@@ -0,0 +1,578 @@
+#include "VM.hpp"
+
+VM::VM(AST_Parser& parser)
+{
+	eval.file_name = parser.file_name;
+	eval.source = parser.source;
+}
+
+void VM::init()
+{
+	eval.init();
+	stack.reserve(256);
+}
+
+VM_Value VM::pop()
+{
+	VM_Value value = std::move(stack.back());
+	stack.pop_back();
+	return value;
+}
+
+std::shared_ptr<AST_Node> VM::box(VM_Value& value)
+{
+	if (value.node)
+	{
+		return value.node;
+	}
+
+	auto node = std::make_shared<AST_Node>(value.type);
+
+	switch (value.type)
+	{
+	case TYPE_INT:
+		node->INT.value = value.int_value;
+		break;
+	case TYPE_FLOAT:
+		node->FLOAT.value = value.float_value;
+		break;
+	case TYPE_BOOL:
+		node->BOOL.value = value.bool_value;
+		break;
+	default:
+		break;
+	}
+
+	return node;
+}
+
+VM_Value VM::unbox(std::shared_ptr<AST_Node> node)
+{
+	switch (node->type)
+	{
+	case TYPE_INT:
+		return VM_Value(node->INT.value);
+	case TYPE_FLOAT:
+		return VM_Value(node->FLOAT.value);
+	case TYPE_BOOL:
+		return VM_Value(node->BOOL.value);
+	default:
+		return VM_Value(node);
+	}
+}
+
+AST_Node* VM::lookup(VM_Cache& cache, ID_Node& id)
+{
+	auto scope = eval.current_scope.get();
+	if (cache.epoch == epoch && cache.scope == scope && cache.activation == scope->SCOPE().activation)
+	{
+		return cache.var;
+	}
+
+	// Misses are not cached (epoch 0 never matches), the name may be defined later
+	auto var = eval.get_data(id);
+	cache = { scope, scope->SCOPE().activation, var.get(), var, var ? epoch : 0 };
+
+	return cache.var;
+}
+
+VM_Value VM::load_value(std::shared_ptr<AST_Node>& node, VM_Cache& cache)
+{
+	auto var = lookup(cache, node->ID());
+
+	if (!var)
+	{
+		std::cout << "\n" << eval.log_error(node, "Variable '" + node->ID().value + "' is not defined.");
+		return VM_Value(eval.create_error(node));
+	}
+
+	Value value = var->VAR().value;
+
+	if (value.is_int())
+	{
+		return VM_Value(value.as_int());
+	}
+	else if (value.is_float())
+	{
+		return VM_Value(value.as_float());
+	}
+	else if (value.is_bool())
+	{
+		return VM_Value(value.as_bool());
+	}
+
+	return unbox(var->VAR().get());
+}
+
+bool VM::is_true(VM_Value& value)
+{
+	if (value.node)
+	{
+		auto node = value.node;
+		eval.eval_var(node);
+		return node->BOOL.value == true;
+	}
+
+	return value.type == TYPE_BOOL && value.bool_value;
+}
+
+void VM::print_value(VM_Value& value)
+{
+	switch (value.node ? TYPE_EMPTY : value.type)
+	{
+	case TYPE_INT:
+		std::cout << value.int_value;
+		break;
+	case TYPE_FLOAT:
+		printf("%f", value.float_value);
+		break;
+	case TYPE_BOOL:
+		std::cout << value.bool_value;
+		break;
+	default:
+		print_ast_node(value.node);
+		break;
+	}
+}
+
+// ########### ASSIGNMENT ########### //
+
+void VM::store(std::shared_ptr<AST_Node>& node, VM_Cache& cache, VM_Value& value, bool keep)
+{
+	if (value.type == TYPE_ERROR)
+	{
+		if (keep)
+			stack.push_back(VM_Value(eval.create_error(node)));
+		return;
+	}
+
+	auto var = lookup(cache, node->left->ID());
+
+	// Same-typed primitive store: nothing to check, and the value goes in unboxed
+	if (var && !value.node && value.type != TYPE_EMPTY && var->VAR().type == value_type_id(value.type))
+	{
+		if (value.type == TYPE_FLOAT)
+			var->VAR().set(Value::from_float(value.float_value));
+		else if (value.type == TYPE_BOOL)
+			var->VAR().set(Value::from_bool(value.bool_value));
+		else if (Value::fits_int(value.int_value))
+			var->VAR().set(Value::from_int(value.int_value));
+		else
+			var->VAR().set(box(value));
+
+		if (keep)
+			stack.push_back(value);
+		return;
+	}
+
+	auto owned = cache.var_ref.lock();
+	auto result = eval.store(node, owned, box(value));
+
+	if (keep)
+		stack.push_back(unbox(result));
+}
+
+// ########### OPERATORS ########### //
+
+VM_Value VM::binary(Op op, std::shared_ptr<AST_Node>& node, VM_Value& left, VM_Value& right)
+{
+	auto l = box(left);
+	auto r = box(right);
+	eval.eval_var(l);
+	eval.eval_var(r);
+
+	switch (op)
+	{
+	case OP_ADD:
+		return unbox(eval.apply_plus(node, l, r));
+	case OP_SUB:
+		return unbox(eval.apply_minus(node, l, r));
+	case OP_MUL:
+		return unbox(eval.apply_mul(node, l, r));
+	case OP_DIV:
+		return unbox(eval.apply_div(node, l, r));
+	case OP_EQ:
+		return unbox(eval.apply_eq_check(node, l, r));
+	default:
+		return unbox(eval.apply_not_eq_check(node, l, r));
+	}
+}
+
+VM_Value VM::unary(Op op, std::shared_ptr<AST_Node>& node, VM_Value& right)
+{
+	auto r = box(right);
+	eval.eval_var(r);
+
+	if (op == OP_NEG)
+	{
+		return unbox(eval.apply_neg(node, r));
+	}
+
+	return unbox(eval.apply_pos(node, r));
+}
+
+#define NUMERIC(v) ((v).type == TYPE_INT || (v).type == TYPE_FLOAT)
+#define AS_FLOAT(v) ((v).type == TYPE_INT ? (double)(v).int_value : (v).float_value)
+
+#define ARITHMETIC_OP(op_code, op)																\
+{																								\
+	VM_Value right = pop();																		\
+	VM_Value& left = stack.back();																\
+	if (left.type == TYPE_INT && right.type == TYPE_INT && !left.node && !right.node)			\
+		left.int_value = left.int_value op right.int_value;										\
+	else if (NUMERIC(left) && NUMERIC(right) && !left.node && !right.node)						\
+		left = VM_Value(AS_FLOAT(left) op AS_FLOAT(right));										\
+	else																						\
+		left = binary(op_code, chunk->nodes[ins.arg], left, right);								\
+	break;																						\
+}
+
+#define EQUALITY_OP(op_code, op)																\
+{																								\
+	VM_Value right = pop();																		\
+	VM_Value& left = stack.back();																\
+	if (left.type == TYPE_INT && right.type == TYPE_INT && !left.node && !right.node)			\
+		left = VM_Value(left.int_value op right.int_value);										\
+	else if (NUMERIC(left) && NUMERIC(right) && !left.node && !right.node)						\
+		left = VM_Value(AS_FLOAT(left) op AS_FLOAT(right));										\
+	else if (left.type == TYPE_BOOL && right.type == TYPE_BOOL && !left.node && !right.node)	\
+		left = VM_Value(left.bool_value op right.bool_value);									\
+	else																						\
+		left = binary(op_code, chunk->nodes[ins.arg], left, right);								\
+	break;																						\
+}
+
+// ########### CALL ########### //
+
+bool VM::load_func(std::shared_ptr<AST_Node>& node)
+{
+	auto func_var = eval.get_data(node->CALL().name);
+	if (!func_var || func_var->VAR().value.type() != TYPE_FUNC_DEF)
+	{
+		std::cout << "\n" << eval.log_error(node, "Function '" + node->CALL().name + "' is not defined.");
+		stack.push_back(VM_Value(eval.create_error(node)));
+		return false;
+	}
+
+	auto& func = func_var->VAR().node;
+	if (func->FUNC_DEF().params.size() != node->CALL().args.size())
+	{
+		std::cout << "\n" << eval.log_error(node, "Function '" + node->CALL().name + "' expects " +
+			std::to_string(func->FUNC_DEF().params.size()) + " argument(s).");
+		stack.push_back(VM_Value(eval.create_error(node)));
+		return false;
+	}
+
+	stack.push_back(VM_Value(func));
+	return true;
+}
+
+void VM::call(std::shared_ptr<AST_Node>& node)
+{
+	// The function OP_LOAD_FUNC pushed sits below the arguments
+	int argc = node->CALL().args.size();
+	size_t base = stack.size() - argc - 1;
+	auto func = stack[base].node;
+
+	if (!materialize_body(func->FUNC_DEF()))
+	{
+		stack.resize(base);
+		std::cout << "\n" << eval.log_error(node, "Function '" + node->CALL().name + "' has syntax errors in its body.");
+		stack.push_back(VM_Value(eval.create_error(node)));
+		return;
+	}
+
+	eval.push_frame(func->FUNC_DEF());
+	for (int i = 0; i < argc; i++)
+	{
+		auto& arg = stack[base + 1 + i];
+		if (arg.node)
+			eval.bind_param(func->FUNC_DEF(), i, arg.node);
+		else if (arg.type == TYPE_INT && Value::fits_int(arg.int_value))
+			eval.bind_param(func->FUNC_DEF(), i, Value::from_int(arg.int_value));
+		else if (arg.type == TYPE_FLOAT)
+			eval.bind_param(func->FUNC_DEF(), i, Value::from_float(arg.float_value));
+		else if (arg.type == TYPE_BOOL)
+			eval.bind_param(func->FUNC_DEF(), i, Value::from_bool(arg.bool_value));
+		else
+		{
+			auto boxed = box(arg);
+			eval.bind_param(func->FUNC_DEF(), i, boxed);
+		}
+	}
+	stack.resize(base);
+
+	auto& chunk = functions[func.get()];
+	if (!chunk)
+	{
+		AST_Compiler compiler;
+		chunk = compiler.compile_function(func);
+	}
+
+	frames.push_back({ chunk, chunk->code.data(), base, eval.current_scope.get() });
+}
+
+// ########### RUN ########### //
+
+bool VM::run(std::shared_ptr<Chunk> program)
+{
+	frames.push_back({ program, program->code.data(), stack.size(), nullptr });
+
+	Chunk* chunk = program.get();
+	const Instruction* ip = chunk->code.data();
+
+	for (;;)
+	{
+		const Instruction& ins = *ip++;
+
+		switch (ins.op)
+		{
+		case OP_CONSTANT:
+			stack.push_back(chunk->constants[ins.arg]);
+			break;
+
+		case OP_POP:
+			stack.pop_back();
+			break;
+
+		case OP_LOAD:
+		{
+			auto& node = chunk->nodes[ins.arg];
+			auto& cache = chunk->caches[ins.arg];
+			auto var = lookup(cache, node->ID()) ? cache.var_ref.lock() : nullptr;
+			if (!var)
+			{
+				std::cout << "\n" << eval.log_error(node, "Variable '" + node->ID().value + "' is not defined.");
+				var = eval.create_error(node);
+			}
+			stack.push_back(VM_Value(var));
+			break;
+		}
+
+		case OP_LOAD_VALUE:
+			stack.push_back(load_value(chunk->nodes[ins.arg], chunk->caches[ins.arg]));
+			break;
+
+		case OP_STORE:
+		case OP_STORE_POP:
+		{
+			VM_Value value = pop();
+			store(chunk->nodes[ins.arg], chunk->caches[ins.arg], value, ins.op == OP_STORE);
+			break;
+		}
+
+		case OP_STORE_VAR:
+		{
+			VM_Value var = pop();
+			VM_Value value = pop();
+			auto& node = chunk->nodes[ins.arg];
+
+			if (value.type == TYPE_ERROR || var.type != TYPE_VAR)
+			{
+				stack.push_back(VM_Value(eval.create_error(node)));
+				break;
+			}
+
+			stack.push_back(unbox(eval.store(node, var.node, box(value))));
+			break;
+		}
+
+		case OP_ACCESS:
+		{
+			auto& node = chunk->nodes[ins.arg];
+			std::shared_ptr<AST_Node> scope = nullptr;
+
+			if (node->left->type == TYPE_ID)
+			{
+				auto data = eval.get_data(node->left->ID());
+				if (data)
+				{
+					scope = data->VAR().get();
+				}
+			}
+			else if (node->left->type == TYPE_DOUBLE_COLON || node->left->type == TYPE_CALL)
+			{
+				VM_Value left = pop();
+				scope = box(left);
+			}
+
+			stack.push_back(VM_Value(eval.access_scope(node, scope)));
+			break;
+		}
+
+		case OP_ADD:
+			ARITHMETIC_OP(OP_ADD, +)
+
+		case OP_SUB:
+			ARITHMETIC_OP(OP_SUB, -)
+
+		case OP_MUL:
+			ARITHMETIC_OP(OP_MUL, *)
+
+		case OP_DIV:
+		{
+			VM_Value right = pop();
+			VM_Value& left = stack.back();
+			if (NUMERIC(left) && NUMERIC(right) && !left.node && !right.node)
+				left = VM_Value(AS_FLOAT(left) / AS_FLOAT(right));
+			else
+				left = binary(OP_DIV, chunk->nodes[ins.arg], left, right);
+			break;
+		}
+
+		case OP_EQ:
+			EQUALITY_OP(OP_EQ, ==)
+
+		case OP_NOT_EQ:
+			EQUALITY_OP(OP_NOT_EQ, !=)
+
+		case OP_NEG:
+		{
+			VM_Value& right = stack.back();
+			if (right.type == TYPE_INT && !right.node)
+				right.int_value = -right.int_value;
+			else if (right.type == TYPE_FLOAT && !right.node)
+				right.float_value = -right.float_value;
+			else
+				right = unary(OP_NEG, chunk->nodes[ins.arg], right);
+			break;
+		}
+
+		case OP_POS:
+		{
+			VM_Value& right = stack.back();
+			if (!NUMERIC(right) || right.node)
+				right = unary(OP_POS, chunk->nodes[ins.arg], right);
+			break;
+		}
+
+		case OP_ENTER_SCOPE:
+		{
+			auto& node = chunk->nodes[ins.arg];
+			auto scope = node->BLOCK().name.empty() ? eval.new_scope("", node->BLOCK().slots) : eval.new_scope(node->BLOCK().name, node->BLOCK().slots);
+			eval.enter_scope(scope);
+			if (!node->BLOCK().name.empty())
+				epoch++;
+			break;
+		}
+
+		case OP_EXIT_SCOPE:
+			eval.exit_scope();
+			break;
+
+		case OP_JUMP:
+			ip = chunk->code.data() + ins.arg;
+			break;
+
+		case OP_JUMP_IF_FALSE:
+		{
+			VM_Value condition = pop();
+			if (!is_true(condition))
+				ip = chunk->code.data() + ins.arg;
+			break;
+		}
+
+		case OP_DEF:
+			eval.eval_func_def(chunk->nodes[ins.arg]);
+			epoch++;
+			stack.push_back(VM_Value(eval.empty));
+			break;
+
+		case OP_LOAD_FUNC:
+			if (load_func(chunk->nodes[ins.arg]))
+				ip++;
+			break;
+
+		case OP_CALL:
+			frames.back().ip = ip;
+			call(chunk->nodes[ins.arg]);
+			chunk = frames.back().chunk.get();
+			ip = frames.back().ip;
+			break;
+
+		case OP_RETURN:
+		{
+			VM_Value result = pop();
+			VM_Frame& frame = frames.back();
+
+			while (eval.current_scope.get() != frame.scope)
+			{
+				eval.exit_scope();
+			}
+			eval.pop_frame();
+
+			stack.resize(frame.base);
+			frames.pop_back();
+
+			chunk = frames.back().chunk.get();
+			ip = frames.back().ip;
+			stack.push_back(result);
+			break;
+		}
+
+		case OP_PRINT:
+		{
+			size_t base = stack.size() - ins.arg;
+			for (size_t i = base; i < stack.size(); i++)
+			{
+				print_value(stack[i]);
+			}
+			stack.resize(base);
+			stack.push_back(VM_Value(eval.empty));
+			break;
+		}
+
+		case OP_TYPE_OF:
+		{
+			VM_Value value = pop();
+			auto arg = box(value);
+			stack.push_back(VM_Value(eval.infer_type(arg)));
+			break;
+		}
+
+		case OP_STR:
+		{
+			VM_Value value = pop();
+			auto arg = box(value);
+			stack.push_back(unbox(eval.call_str(arg)));
+			break;
+		}
+
+		case OP_REF:
+		{
+			VM_Value value = pop();
+			auto ref = std::make_shared<AST_Node>(TYPE_REF);
+			ref->REF().ref = box(value);
+			stack.push_back(VM_Value(ref));
+			break;
+		}
+
+		case OP_IMPORT:
+			stack.push_back(unbox(eval.call_import(chunk->nodes[ins.arg]->CALL().args[0])));
+			break;
+
+		case OP_BUILTIN_ERROR:
+		{
+			auto& node = chunk->nodes[ins.arg];
+			std::cout << "\n" + eval.log_error(node, "Built-in function '" + node->CALL().name + "' only accepts one argument.");
+			stack.push_back(VM_Value(eval.create_error(node)));
+			break;
+		}
+
+		case OP_END_STATEMENT:
+		{
+			VM_Value result = pop();
+			if (result.type == TYPE_ERROR)
+			{
+				frames.pop_back();
+				return false;
+			}
+			break;
+		}
+
+		case OP_HALT:
+			frames.pop_back();
+			return true;
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <unordered_map>
+#include "Bytecode.hpp"
+#include "AST_Compiler.hpp"
+#include "AST_Eval.hpp"
+
+struct VM_Frame
+{
+	std::shared_ptr<Chunk> chunk = nullptr;
+	const Instruction* ip = nullptr;
+	size_t base = 0;
+
+	// The call's frame, only compared against, so it doesn't keep the frame from being reused
+	AST_Node* scope = nullptr;
+};
+
+// Stack machine for chunks produced by AST_Compiler. Scopes, variables, type checks and
+// built-ins are shared with AST_Eval, so both engines see the same runtime model.
+class VM
+{
+	std::vector<VM_Value> stack;
+	std::vector<VM_Frame> frames;
+	std::unordered_map<AST_Node*, std::shared_ptr<Chunk>> functions;
+	size_t epoch = 1;
+
+	VM_Value pop();
+
+	std::shared_ptr<AST_Node> box(VM_Value& value);
+
+	VM_Value unbox(std::shared_ptr<AST_Node> node);
+
+	AST_Node* lookup(VM_Cache& cache, ID_Node& id);
+
+	VM_Value load_value(std::shared_ptr<AST_Node>& node, VM_Cache& cache);
+
+	bool is_true(VM_Value& value);
+
+	void store(std::shared_ptr<AST_Node>& node, VM_Cache& cache, VM_Value& value, bool keep);
+
+	VM_Value binary(Op op, std::shared_ptr<AST_Node>& node, VM_Value& left, VM_Value& right);
+
+	VM_Value unary(Op op, std::shared_ptr<AST_Node>& node, VM_Value& right);
+
+	// Pushes the function 'node' calls, or an error if it can't be called with its arguments
+	bool load_func(std::shared_ptr<AST_Node>& node);
+
+	void call(std::shared_ptr<AST_Node>& node);
+
+	void print_value(VM_Value& value);
+
+public:
+
+	AST_Eval eval;
+
+	VM() = default;
+
+	VM(AST_Parser& parser);
+
+	void init();
+
+	// Returns false if a top-level statement evaluated to an error
+	bool run(std::shared_ptr<Chunk> chunk);
+};
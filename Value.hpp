@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "Type.hpp"
+
+struct AST_Node;
+
+// A runtime value in one 64-bit word. Floats are stored as their own bits. Everything else
+// lives in the payload of a negative quiet NaN with bit 50 set, which no arithmetic produces
+// on its own, tagged by bits 48-49:
+//
+//   object  0xFFFC | 48-bit AST_Node*     (strings, lists, scopes, functions, wide ints, ...)
+//   int     0xFFFD | 48-bit signed int
+//   bool    0xFFFE | 0 or 1
+//   empty   0xFFFF | 0
+//
+// An object value doesn't own its node; whatever stores the Value keeps the node alive.
+class Value
+{
+	static const uint64_t BOXED = 0xFFFC000000000000;
+	static const uint64_t TAG = 0xFFFF000000000000;
+	static const uint64_t PAYLOAD = 0x0000FFFFFFFFFFFF;
+
+	static const uint64_t OBJECT = BOXED;
+	static const uint64_t INT = BOXED | (1ull << 48);
+	static const uint64_t BOOL = BOXED | (2ull << 48);
+	static const uint64_t EMPTY = BOXED | (3ull << 48);
+
+	uint64_t bits = EMPTY;
+
+	static Value from_bits(uint64_t bits)
+	{
+		Value value;
+		value.bits = bits;
+		return value;
+	}
+
+public:
+
+	// Ints outside [MIN_INT, MAX_INT] have to be kept as objects
+	static const int64_t MIN_INT = -(1ll << 47);
+	static const int64_t MAX_INT = (1ll << 47) - 1;
+
+	static bool fits_int(int64_t value) { return value >= MIN_INT && value <= MAX_INT; }
+
+	static Value from_int(int64_t value) { return from_bits(INT | ((uint64_t)value & PAYLOAD)); }
+
+	static Value from_float(double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		// A NaN that happens to look boxed becomes the default NaN
+		if ((bits & BOXED) == BOXED)
+		{
+			bits = 0xFFF8000000000000;
+		}
+
+		return from_bits(bits);
+	}
+
+	static Value from_bool(bool value) { return from_bits(BOOL | value); }
+
+	static Value from_object(AST_Node* node) { return from_bits(OBJECT | (uint64_t)node); }
+
+	bool is_float() const { return (bits & BOXED) != BOXED; }
+	bool is_int() const { return (bits & TAG) == INT; }
+	bool is_bool() const { return (bits & TAG) == BOOL; }
+	bool is_empty() const { return bits == EMPTY; }
+	bool is_object() const { return (bits & TAG) == OBJECT; }
+
+	// Sign-extends the 48-bit payload
+	int64_t as_int() const { return (int64_t)(bits << 16) >> 16; }
+
+	double as_float() const
+	{
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	bool as_bool() const { return bits & 1; }
+
+	AST_Node* as_object() const { return (AST_Node*)(bits & PAYLOAD); }
+
+	// An object's type is its node's; defined in AST_Node.hpp
+	Type type() const;
+
+	bool operator==(const Value& other) const { return bits == other.bits; }
+};
+
+static_assert(sizeof(Value) == 8, "Value should stay one word");